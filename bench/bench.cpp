@@ -0,0 +1,244 @@
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cnf.h"
+#include "dpll.h"
+#include "frontend.h"
+#include "generators.h"
+
+#define DEFAULT_TRIALS 5
+#define DEFAULT_SEED 2017
+// slowdowns beyond this ratio against the baseline are flagged
+#define REGRESSION_RATIO 1.2
+
+struct bench_result {
+  std::string name;
+  std::string result;
+  double median_ms;
+  double p95_ms;
+};
+
+// nearest-rank percentile of a sorted sample
+double percentile(const std::vector<double> &sorted, double p) {
+  size_t rank = static_cast<size_t>(p * sorted.size() + 0.999999);
+  if (rank < 1) rank = 1;
+  if (rank > sorted.size()) rank = sorted.size();
+  return sorted[rank - 1];
+}
+
+std::vector<bench_instance> build_suite(unsigned seed) {
+  std::mt19937 rng(seed);
+  std::vector<bench_instance> suite;
+
+  int random_sizes[] = {40, 60, 80};
+  for (int n : random_sizes) suite.push_back(gen_random_3sat(n, 4.26, rng));
+
+  int holes[] = {5, 6, 7};
+  for (int h : holes) suite.push_back(gen_pigeonhole(h));
+
+  int parity_sizes[] = {32, 64, 128};
+  for (int n : parity_sizes) suite.push_back(gen_parity_chain(n, true));
+
+  int parity_unsat_sizes[] = {8, 10, 12};
+  for (int n : parity_unsat_sizes) suite.push_back(gen_parity_unsat(n, rng));
+
+  int coloring_sizes[] = {20, 40, 60};
+  for (int n : coloring_sizes) suite.push_back(gen_graph_coloring(n, 0.5, 3, rng));
+
+  return suite;
+}
+
+bench_result run_instance(bench_instance &inst, int trials, const dpll_options &opts,
+                          std::ostream &null_stream) {
+  bench_result res;
+  res.name = inst.name();
+  std::vector<double> times;
+  bool is_sat = false;
+
+  for (int t = 0; t < trials; t++) {
+    assignment asmt;
+    auto start = std::chrono::steady_clock::now();
+    is_sat = dpll_sat(inst.cnf, inst.num_vars, opts, asmt, null_stream);
+    auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+
+  res.result = is_sat ? "SAT" : "NON-SAT";
+  if ((inst.expected == expect_sat && !is_sat) ||
+      (inst.expected == expect_unsat && is_sat)) {
+    res.result = "WRONG";
+  }
+
+  std::sort(times.begin(), times.end());
+  res.median_ms = percentile(times, 0.5);
+  res.p95_ms = percentile(times, 0.95);
+  return res;
+}
+
+// baseline file: one "name result median_ms p95_ms" line per instance
+std::map<std::string, bench_result> read_baseline(const std::string &path) {
+  std::map<std::string, bench_result> baseline;
+  std::ifstream in(path.c_str());
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream iss(line);
+    bench_result r;
+    if (iss >> r.name >> r.result >> r.median_ms >> r.p95_ms) baseline[r.name] = r;
+  }
+  return baseline;
+}
+
+void write_baseline(const std::string &path, std::vector<bench_result> &results, int trials) {
+  std::ofstream out(path.c_str());
+  out << "# name result median_ms p95_ms (" << trials << " trials)" << std::endl;
+  out << std::fixed << std::setprecision(3);
+  for (auto it = results.begin(); it != results.end(); it++) {
+    out << it->name << " " << it->result << " "
+        << it->median_ms << " " << it->p95_ms << std::endl;
+  }
+}
+
+void usage(char *prog) {
+  std::cerr << "usage: " << prog << " [-n trials] [-s seed] [-f family] [-x] [-y] [-d] [-p]"
+            << " [-b baseline] [-w baseline]" << std::endl
+            << "       " << prog << " [-s seed] -g formula-params" << std::endl;
+}
+
+int main(int argc, char **argv) {
+  int trials = DEFAULT_TRIALS;
+  unsigned seed = DEFAULT_SEED;
+  std::string family_filter;
+  std::string baseline_in;
+  std::string baseline_out;
+  dpll_options opts;
+  bool frontend = false;
+  std::string formula_spec;
+  bool generate = false;
+
+  int c;
+  while ((c = getopt(argc, argv, "n:s:f:xydpg:b:w:")) != -1) {
+    switch (c) {
+      case 'n':
+        trials = std::atoi(optarg);
+        break;
+      case 's':
+        seed = std::strtoul(optarg, nullptr, 10);
+        break;
+      case 'f':
+        family_filter = optarg;
+        break;
+      case 'x':
+        opts.use_xor = true;
+        break;
+      case 'y':
+        opts.use_symmetry = true;
+        break;
+      case 'd':
+        opts.use_bitset = false;
+        break;
+      case 'p':
+        frontend = true;
+        break;
+      case 'g':
+        formula_spec = optarg;
+        generate = true;
+        break;
+      case 'b':
+        baseline_in = optarg;
+        break;
+      case 'w':
+        baseline_out = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+  if (trials < 1) trials = 1;
+
+  if (generate) {
+    formula_params p;
+    if (!parse_formula_params(formula_spec, p)) {
+      std::cerr << "bad formula parameters: " << formula_spec << std::endl;
+      return 1;
+    }
+    std::mt19937 rng(seed);
+    std::cout << gen_formula(p, rng) << std::endl;
+    return 0;
+  }
+  if (frontend) return run_frontend(trials, seed, REGRESSION_RATIO, baseline_in, baseline_out);
+
+  null_buffer nb;
+  std::ostream null_stream(&nb);
+
+  std::map<std::string, bench_result> baseline;
+  if (!baseline_in.empty()) baseline = read_baseline(baseline_in);
+
+  std::vector<bench_instance> suite = build_suite(seed);
+  std::vector<bench_result> results;
+  int regressions = 0;
+  int wrong = 0;
+
+  std::cout << std::left << std::setw(30) << "instance"
+            << std::right << std::setw(7) << "vars"
+            << std::setw(9) << "clauses"
+            << std::setw(9) << "result"
+            << std::setw(12) << "median_ms"
+            << std::setw(12) << "p95_ms";
+  if (!baseline.empty()) std::cout << std::setw(10) << "vs base";
+  std::cout << std::endl;
+
+  for (auto it = suite.begin(); it != suite.end(); it++) {
+    if (!family_filter.empty() && it->family != family_filter) continue;
+
+    bench_result r = run_instance(*it, trials, opts, null_stream);
+    results.push_back(r);
+    if (r.result == "WRONG") wrong++;
+
+    std::cout << std::left << std::setw(30) << r.name
+              << std::right << std::setw(7) << it->num_vars
+              << std::setw(9) << it->cnf->clauses.size()
+              << std::setw(9) << r.result
+              << std::fixed << std::setprecision(3)
+              << std::setw(12) << r.median_ms
+              << std::setw(12) << r.p95_ms;
+
+    auto base = baseline.find(r.name);
+    if (base != baseline.end() && base->second.median_ms > 0) {
+      double ratio = r.median_ms / base->second.median_ms;
+      std::cout << std::setw(9) << std::setprecision(2) << ratio << "x";
+      if (ratio > REGRESSION_RATIO) {
+        std::cout << " REGRESSION";
+        regressions++;
+      }
+    }
+    std::cout << std::endl;
+  }
+
+  for (auto it = suite.begin(); it != suite.end(); it++) free_cnf(it->cnf);
+
+  if (!baseline_out.empty()) {
+    write_baseline(baseline_out, results, trials);
+    std::cout << std::endl << "Baseline written to " << baseline_out << std::endl;
+  }
+
+  if (!baseline.empty()) {
+    std::cout << std::endl << regressions << " regression(s) against " << baseline_in << std::endl;
+  }
+  if (wrong > 0) {
+    std::cout << wrong << " instance(s) with WRONG results" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
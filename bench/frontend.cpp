@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "dpll.h"
+#include "frontend.h"
+#include "generators.h"
+#include "implication.h"
+#include "parser.h"
+#include "tseitin.h"
+
+struct frontend_result {
+  std::string name;
+  double parse_ms;
+  double cnf_ms;
+  double tseitin_ms;
+};
+
+// peaks of the resident memory during the stages of the last trial, and
+// the memory the CNF holds as clause objects and once its binaries are
+// split off as the DPLL search takes them
+struct frontend_memory {
+  size_t parse_bytes;
+  size_t tseitin_bytes;
+  size_t cnf_bytes;
+  size_t split_bytes;
+};
+
+static std::vector<formula_params> build_frontend_suite() {
+  std::vector<formula_params> suite;
+  formula_params p;
+
+  int depths[] = {6, 8, 9};
+  for (int d : depths) {
+    p.depth = d;
+    suite.push_back(p);
+  }
+
+  // repeated subformulas
+  p.depth = 8;
+  p.sharing = 0.3;
+  suite.push_back(p);
+
+  // equivalences and implications only, the costliest to encode
+  p.sharing = 0;
+  p.mix[0] = p.mix[1] = 0;
+  suite.push_back(p);
+
+  // shallow and wide, over many variables
+  p = formula_params();
+  p.depth = 4;
+  p.fanout = 16;
+  p.num_vars = 100000;
+  suite.push_back(p);
+
+  return suite;
+}
+
+// the kernel restarts the peak of the resident memory when 5 is written
+// to clear_refs; without it the peak of the whole run is reported. freed
+// memory the allocator still holds is given back first, or it would count.
+static void reset_peak_memory() {
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+}
+
+// memory allocated and not freed yet. freed clause objects are scattered
+// between live ones, so the allocator keeps their pages and the resident
+// memory hardly drops, but the space is reused by what comes next.
+static size_t held_bytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  return mallinfo2().uordblks;
+#else
+  return current_memory_bytes();
+#endif
+}
+
+static size_t bytes_above(size_t bytes, size_t base) {
+  return bytes > base ? bytes - base : 0;
+}
+
+static size_t stage_peak_bytes() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") != 0) continue;
+    std::istringstream iss(line.substr(6));
+    size_t kb;
+    if (iss >> kb) return kb * 1024;
+  }
+  return peak_memory_bytes();
+}
+
+// every node of f, variables counted once per occurrence
+static size_t count_nodes(Formula *f) {
+  size_t nodes = 0;
+  std::vector<Formula *> stack(1, f);
+  while (!stack.empty()) {
+    Formula *g = stack.back();
+    stack.pop_back();
+    nodes++;
+    switch (g->type) {
+      case Formula::variable:
+        break;
+      case Formula::negated:
+        stack.push_back(static_cast<Negated *>(g)->f);
+        break;
+      case Formula::binary:
+        stack.push_back(static_cast<Binary *>(g)->l);
+        stack.push_back(static_cast<Binary *>(g)->r);
+        break;
+      case Formula::cardinality: {
+        std::vector<Formula *> &ops = static_cast<Cardinality *>(g)->operands;
+        stack.insert(stack.end(), ops.begin(), ops.end());
+        break;
+      }
+    }
+  }
+  return nodes;
+}
+
+static double ms_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double median(std::vector<double> &times) {
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+// frontend baseline file: one "name parse_ms cnf_ms tseitin_ms" line per instance
+static std::map<std::string, frontend_result> read_frontend_baseline(const std::string &path) {
+  std::map<std::string, frontend_result> baseline;
+  std::ifstream in(path.c_str());
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream iss(line);
+    frontend_result r;
+    if (iss >> r.name >> r.parse_ms >> r.cnf_ms >> r.tseitin_ms) baseline[r.name] = r;
+  }
+  return baseline;
+}
+
+static void write_frontend_baseline(const std::string &path,
+                                    std::vector<frontend_result> &results, int trials) {
+  std::ofstream out(path.c_str());
+  out << "# name parse_ms cnf_ms tseitin_ms (" << trials << " trials)" << std::endl;
+  out << std::fixed << std::setprecision(3);
+  for (auto it = results.begin(); it != results.end(); it++) {
+    out << it->name << " " << it->parse_ms << " " << it->cnf_ms << " " << it->tseitin_ms
+        << std::endl;
+  }
+}
+
+int run_frontend(int trials, unsigned seed, double regression_ratio,
+                 const std::string &baseline_in, const std::string &baseline_out) {
+  std::map<std::string, frontend_result> baseline;
+  if (!baseline_in.empty()) baseline = read_frontend_baseline(baseline_in);
+
+  std::vector<formula_params> suite = build_frontend_suite();
+  std::vector<frontend_result> results;
+  int regressions = 0;
+  int failed = 0;
+
+  std::cout << std::left << std::setw(52) << "instance"
+            << std::right << std::setw(8) << "MB"
+            << std::setw(9) << "nodes"
+            << std::setw(10) << "parse_ms"
+            << std::setw(8) << "MB/s"
+            << std::setw(8) << "cnf_ms"
+            << std::setw(12) << "tseitin_ms"
+            << std::setw(11) << "knodes/s"
+            << std::setw(9) << "vars"
+            << std::setw(10) << "clauses"
+            << std::setw(11) << "parse_MB"
+            << std::setw(12) << "tseitin_MB"
+            << std::setw(8) << "cnf_MB"
+            << std::setw(10) << "split_MB";
+  if (!baseline.empty()) std::cout << std::setw(10) << "vs base";
+  std::cout << std::endl;
+
+  for (auto it = suite.begin(); it != suite.end(); it++) {
+    std::mt19937 rng(seed);
+    std::string text = gen_formula(*it, rng);
+
+    frontend_result r;
+    r.name = "formula/" + it->name();
+    std::vector<double> parse_times, cnf_times, tseitin_times;
+    frontend_memory mem = {0, 0, 0, 0};
+    size_t nodes = 0, num_vars = 0, num_clauses = 0;
+    bool ok = true;
+
+    for (int t = 0; t < trials && ok; t++) {
+      // the parser works in place, every trial gets a fresh copy
+      std::vector<char> input(text.begin(), text.end());
+      input.push_back('\0');
+
+      reset_peak_memory();
+      auto start = std::chrono::steady_clock::now();
+      parse_result *pr = parse_formula(input.data(), input.data() + text.size());
+      parse_times.push_back(ms_since(start));
+      mem.parse_bytes = stage_peak_bytes();
+      if (pr->has_error()) {
+        free_parse_result(pr);
+        ok = false;
+        break;
+      }
+
+      start = std::chrono::steady_clock::now();
+      CNF *direct = parse_into_cnf(pr->f);
+      cnf_times.push_back(ms_since(start));
+      if (direct) free_cnf(direct);
+
+      nodes = count_nodes(pr->f);
+      reset_peak_memory();
+      start = std::chrono::steady_clock::now();
+      tseitin_init(pr->Vmap, pr->Rmap);
+      CNF *cnf = tseitin_transform(pr->f);
+      tseitin_times.push_back(ms_since(start));
+      mem.tseitin_bytes = stage_peak_bytes();
+
+      num_vars = pr->Rmap->size();
+      num_clauses = cnf->clauses.size();
+
+      size_t with_cnf = held_bytes();
+      std::vector<std::pair<lit, lit> > binaries;
+      split_binaries(cnf, binaries);
+      size_t with_split = held_bytes();
+      free_cnf(cnf);
+      std::vector<std::pair<lit, lit> >().swap(binaries);
+      size_t without = held_bytes();
+      mem.cnf_bytes = bytes_above(with_cnf, without);
+      mem.split_bytes = bytes_above(with_split, without);
+      free_parse_result(pr);
+    }
+
+    if (!ok) {
+      std::cout << std::left << std::setw(52) << r.name << " PARSE ERROR" << std::endl;
+      failed++;
+      continue;
+    }
+
+    r.parse_ms = median(parse_times);
+    r.cnf_ms = median(cnf_times);
+    r.tseitin_ms = median(tseitin_times);
+    results.push_back(r);
+
+    double mb = text.size() / 1e6;
+    std::cout << std::left << std::setw(52) << r.name
+              << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << mb
+              << std::setw(9) << nodes
+              << std::setprecision(3)
+              << std::setw(10) << r.parse_ms
+              << std::setprecision(1)
+              << std::setw(8) << mb / (r.parse_ms / 1000)
+              << std::setprecision(3)
+              << std::setw(8) << r.cnf_ms
+              << std::setw(12) << r.tseitin_ms
+              << std::setprecision(1)
+              << std::setw(11) << nodes / r.tseitin_ms
+              << std::setw(9) << num_vars
+              << std::setw(10) << num_clauses
+              << std::setw(11) << mem.parse_bytes / 1e6
+              << std::setw(12) << mem.tseitin_bytes / 1e6
+              << std::setw(8) << mem.cnf_bytes / 1e6
+              << std::setw(10) << mem.split_bytes / 1e6;
+
+    auto base = baseline.find(r.name);
+    if (base != baseline.end() && base->second.parse_ms > 0 && base->second.tseitin_ms > 0) {
+      // the slower of the two main stages
+      double ratio = std::max(r.parse_ms / base->second.parse_ms,
+                              r.tseitin_ms / base->second.tseitin_ms);
+      std::cout << std::setw(9) << std::setprecision(2) << ratio << "x";
+      if (ratio > regression_ratio) {
+        std::cout << " REGRESSION";
+        regressions++;
+      }
+    }
+    std::cout << std::endl;
+  }
+
+  if (!baseline_out.empty()) {
+    write_frontend_baseline(baseline_out, results, trials);
+    std::cout << std::endl << "Baseline written to " << baseline_out << std::endl;
+  }
+
+  if (!baseline.empty()) {
+    std::cout << std::endl << regressions << " regression(s) against " << baseline_in << std::endl;
+  }
+  if (failed > 0) {
+    std::cout << failed << " formula(s) failed to parse" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,14 @@
+#ifndef FRONTEND_H
+#define FRONTEND_H
+
+#include <string>
+
+// Runs the front-end suite: generated infix formulas of several shapes go
+// through parse_formula, parse_into_cnf and tseitin_transform, and the
+// median time, throughput and resident memory peak of every stage are
+// reported. Baselines work as in the solver suite, with slowdowns of parse
+// or transform beyond regression_ratio flagged. Returns the exit code.
+int run_frontend(int trials, unsigned seed, double regression_ratio,
+                 const std::string &baseline_in, const std::string &baseline_out);
+
+#endif /* FRONTEND_H */
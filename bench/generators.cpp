@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include "generators.h"
+
+static void add_literal(Clause *C, var v, bool is_pos) {
+  C->literals.push_back(mk_lit(v, is_pos));
+}
+
+bench_instance gen_random_3sat(int num_vars, double ratio, std::mt19937 &rng) {
+  CNF *cnf = new CNF();
+  int num_clauses = static_cast<int>(num_vars * ratio + 0.5);
+  std::uniform_int_distribution<int> pick_var(0, num_vars - 1);
+  std::bernoulli_distribution pick_sign(0.5);
+
+  for (int i = 0; i < num_clauses; i++) {
+    Clause *C = new Clause();
+    var vs[3];
+    // three distinct variables per clause
+    for (int j = 0; j < 3; j++) {
+      bool dup;
+      do {
+        vs[j] = pick_var(rng);
+        dup = false;
+        for (int k = 0; k < j; k++) dup = dup || vs[k] == vs[j];
+      } while (dup);
+      add_literal(C, vs[j], pick_sign(rng));
+    }
+    cnf->clauses.push_back(C);
+  }
+
+  std::ostringstream params;
+  params << "n=" << num_vars << ",r=" << ratio;
+  return bench_instance("random3sat", params.str(), cnf, num_vars, expect_unknown);
+}
+
+bench_instance gen_pigeonhole(int holes) {
+  CNF *cnf = new CNF();
+  int pigeons = holes + 1;
+  // var(p, h) = p * holes + h: pigeon p sits in hole h
+
+  // every pigeon sits somewhere
+  for (int p = 0; p < pigeons; p++) {
+    Clause *C = new Clause();
+    for (int h = 0; h < holes; h++) add_literal(C, p * holes + h, true);
+    cnf->clauses.push_back(C);
+  }
+
+  // no two pigeons share a hole
+  for (int h = 0; h < holes; h++) {
+    for (int p = 0; p < pigeons; p++) {
+      for (int q = p + 1; q < pigeons; q++) {
+        Clause *C = new Clause();
+        add_literal(C, p * holes + h, false);
+        add_literal(C, q * holes + h, false);
+        cnf->clauses.push_back(C);
+      }
+    }
+  }
+
+  std::ostringstream params;
+  params << "holes=" << holes;
+  return bench_instance("pigeonhole", params.str(), cnf, pigeons * holes, expect_unsat);
+}
+
+// c <-> (a ^ b)
+static void add_xor(CNF *cnf, var a, var b, var c) {
+  static const bool signs[4][3] = {
+    {false, false, false},
+    {true, true, false},
+    {true, false, true},
+    {false, true, true},
+  };
+  for (int i = 0; i < 4; i++) {
+    Clause *C = new Clause();
+    add_literal(C, a, signs[i][0]);
+    add_literal(C, b, signs[i][1]);
+    add_literal(C, c, signs[i][2]);
+    cnf->clauses.push_back(C);
+  }
+}
+
+// chains the parity of inputs through fresh variables starting at first_aux
+static void add_parity_chain(CNF *cnf, const std::vector<var> &inputs, var first_aux, bool parity) {
+  var prev = inputs[0];
+  for (size_t i = 1; i < inputs.size(); i++) {
+    var t = first_aux + i - 1;
+    add_xor(cnf, prev, inputs[i], t);
+    prev = t;
+  }
+
+  Clause *C = new Clause();
+  add_literal(C, prev, parity);
+  cnf->clauses.push_back(C);
+}
+
+bench_instance gen_parity_chain(int n, bool parity) {
+  CNF *cnf = new CNF();
+  // x0..x(n-1) are inputs, n..2n-2 hold the running parity t1..t(n-1)
+  std::vector<var> inputs(n);
+  for (int i = 0; i < n; i++) inputs[i] = i;
+  add_parity_chain(cnf, inputs, n, parity);
+
+  std::ostringstream params;
+  params << "n=" << n << ",p=" << parity;
+  return bench_instance("parity", params.str(), cnf, 2 * n - 1, expect_sat);
+}
+
+bench_instance gen_parity_unsat(int n, std::mt19937 &rng) {
+  CNF *cnf = new CNF();
+  std::vector<var> inputs(n);
+  for (int i = 0; i < n; i++) inputs[i] = i;
+  add_parity_chain(cnf, inputs, n, false);
+  std::shuffle(inputs.begin(), inputs.end(), rng);
+  add_parity_chain(cnf, inputs, 2 * n - 1, true);
+
+  std::ostringstream params;
+  params << "n=" << n;
+  return bench_instance("parity-unsat", params.str(), cnf, 3 * n - 2, expect_unsat);
+}
+
+bench_instance gen_graph_coloring(int nodes, double edge_p, int k, std::mt19937 &rng) {
+  CNF *cnf = new CNF();
+  // var(v, c) = v * k + c: node v has color c
+
+  // plant a coloring so the instance is known to be colorable
+  std::uniform_int_distribution<int> pick_color(0, k - 1);
+  std::vector<int> planted(nodes);
+  for (int v = 0; v < nodes; v++) planted[v] = pick_color(rng);
+
+  for (int v = 0; v < nodes; v++) {
+    // at least one color
+    Clause *C = new Clause();
+    for (int c = 0; c < k; c++) add_literal(C, v * k + c, true);
+    cnf->clauses.push_back(C);
+
+    // at most one color
+    for (int c = 0; c < k; c++) {
+      for (int d = c + 1; d < k; d++) {
+        Clause *D = new Clause();
+        add_literal(D, v * k + c, false);
+        add_literal(D, v * k + d, false);
+        cnf->clauses.push_back(D);
+      }
+    }
+  }
+
+  std::bernoulli_distribution pick_edge(edge_p);
+  for (int u = 0; u < nodes; u++) {
+    for (int v = u + 1; v < nodes; v++) {
+      if (planted[u] == planted[v] || !pick_edge(rng)) continue;
+      for (int c = 0; c < k; c++) {
+        Clause *C = new Clause();
+        add_literal(C, u * k + c, false);
+        add_literal(C, v * k + c, false);
+        cnf->clauses.push_back(C);
+      }
+    }
+  }
+
+  std::ostringstream params;
+  params << "n=" << nodes << ",p=" << edge_p << ",k=" << k;
+  return bench_instance("coloring", params.str(), cnf, nodes * k, expect_sat);
+}
+
+std::string formula_params::name() const {
+  std::ostringstream os;
+  os << "d=" << depth << ",k=" << fanout << ",v=" << num_vars << ",mix=" << mix[0] << ":"
+     << mix[1] << ":" << mix[2] << ":" << mix[3] << ",share=" << sharing << ",neg=" << negation;
+  return os.str();
+}
+
+bool parse_formula_params(const std::string &spec, formula_params &p) {
+  std::istringstream in(spec);
+  std::string item;
+  while (std::getline(in, item, ',')) {
+    size_t eq = item.find('=');
+    if (eq == std::string::npos) return false;
+    std::string key = item.substr(0, eq);
+    std::istringstream value(item.substr(eq + 1));
+    char sep;
+    if (key == "d") value >> p.depth;
+    else if (key == "k") value >> p.fanout;
+    else if (key == "v") value >> p.num_vars;
+    else if (key == "mix") {
+      value >> p.mix[0] >> sep >> p.mix[1] >> sep >> p.mix[2] >> sep >> p.mix[3];
+    }
+    else if (key == "share") value >> p.sharing;
+    else if (key == "neg") value >> p.negation;
+    else return false;
+    if (value.fail() || !value.eof()) return false;
+  }
+  int total = p.mix[0] + p.mix[1] + p.mix[2] + p.mix[3];
+  return p.depth >= 0 && p.fanout >= 2 && p.num_vars >= 1 && total > 0 &&
+    p.mix[0] >= 0 && p.mix[1] >= 0 && p.mix[2] >= 0 && p.mix[3] >= 0;
+}
+
+struct formula_generator {
+  const formula_params &p;
+  std::mt19937 &rng;
+  std::string out;
+  // per depth, the (offset, length) in out of every subformula written
+  std::vector<std::vector<std::pair<size_t, size_t> > > written;
+
+  formula_generator(const formula_params &params, std::mt19937 &r) :
+    p(params), rng(r), written(params.depth + 1) {}
+
+  void operand(int depth) {
+    std::bernoulli_distribution negate(p.negation);
+    std::bernoulli_distribution share(p.sharing);
+    if (negate(rng)) out += '!';
+
+    std::vector<std::pair<size_t, size_t> > &same_depth = written[depth];
+    if (!same_depth.empty() && share(rng)) {
+      std::uniform_int_distribution<size_t> pick(0, same_depth.size() - 1);
+      std::pair<size_t, size_t> earlier = same_depth[pick(rng)];
+      out.append(out, earlier.first, earlier.second);
+      return;
+    }
+
+    size_t start = out.size();
+    if (depth == 0) {
+      std::uniform_int_distribution<int> pick_var(0, p.num_vars - 1);
+      out += 'x';
+      out += std::to_string(pick_var(rng));
+    } else {
+      static const char *symbols[4] = {"&", "|", "->", "<->"};
+      std::discrete_distribution<int> pick_op(p.mix, p.mix + 4);
+      const char *op = symbols[pick_op(rng)];
+      out += '(';
+      for (int i = 0; i < p.fanout; i++) {
+        if (i > 0) out += op;
+        operand(depth - 1);
+      }
+      out += ')';
+    }
+    same_depth.emplace_back(start, out.size() - start);
+  }
+};
+
+std::string gen_formula(const formula_params &p, std::mt19937 &rng) {
+  formula_generator gen(p, rng);
+  gen.operand(p.depth);
+  return gen.out;
+}
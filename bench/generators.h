@@ -0,0 +1,76 @@
+#ifndef GENERATORS_H
+#define GENERATORS_H
+
+#include <random>
+#include <string>
+
+#include "cnf.h"
+
+// expected outcome of a generated instance
+enum expected_result {expect_sat, expect_unsat, expect_unknown};
+
+struct bench_instance {
+  std::string family;
+  std::string params;
+  CNF *cnf;
+  int num_vars;
+  expected_result expected;
+
+  bench_instance(std::string fam, std::string p, CNF *c, int n, expected_result e) :
+    family(fam), params(p), cnf(c), num_vars(n), expected(e) {}
+
+  std::string name() const {
+    return family + "/" + params;
+  }
+};
+
+// uniform random 3-SAT with num_vars * ratio clauses (4.26 is the phase transition)
+bench_instance gen_random_3sat(int num_vars, double ratio, std::mt19937 &rng);
+
+// holes+1 pigeons into holes holes, always unsat
+bench_instance gen_pigeonhole(int holes);
+
+// x0 ^ x1 ^ ... ^ x(n-1) = parity, chained through auxiliary partial sums
+bench_instance gen_parity_chain(int n, bool parity);
+
+// two parity chains over the same n variables in different random orders
+// that demand opposite parities, always unsat
+bench_instance gen_parity_unsat(int n, std::mt19937 &rng);
+
+// k-coloring of a random graph with edge probability edge_p
+bench_instance gen_graph_coloring(int nodes, double edge_p, int k, std::mt19937 &rng);
+
+// shape of a generated infix formula
+struct formula_params {
+  // operator levels above the literals
+  int depth;
+  // operands per operator, chained left to right
+  int fanout;
+  int num_vars;
+  // relative weights of &, |, -> and <->
+  int mix[4];
+  // chance that an operand repeats an earlier subformula of the same depth
+  double sharing;
+  // chance that an operand is negated
+  double negation;
+
+  formula_params() : depth(8), fanout(4), num_vars(1000), sharing(0), negation(0.2) {
+    mix[0] = 4;
+    mix[1] = 4;
+    mix[2] = 1;
+    mix[3] = 1;
+  }
+
+  // "d=8,k=4,v=1000,mix=4:4:1:1,share=0,neg=0.2"
+  std::string name() const;
+};
+
+// reads the keys of formula_params::name, any subset in any order, into p.
+// returns false on an unknown key or a bad value.
+bool parse_formula_params(const std::string &spec, formula_params &p);
+
+// random infix formula in the input syntax of the solver, with fanout^depth
+// literals over the variables x0..x(num_vars-1)
+std::string gen_formula(const formula_params &p, std::mt19937 &rng);
+
+#endif /* GENERATORS_H */
@@ -0,0 +1,118 @@
+#ifndef BIGCOUNT_H
+#define BIGCOUNT_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Arbitrary-precision unsigned integer for model counts.
+// Only what counting needs: addition, multiplication, powers of two.
+class bigcount {
+  // little-endian base 2^32 limbs, no trailing zero limbs (zero is empty)
+  std::vector<uint32_t> limbs;
+
+  void trim() {
+    while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+  }
+
+public:
+  bigcount() {}
+  bigcount(uint64_t v) {
+    while (v) {
+      limbs.push_back(static_cast<uint32_t>(v));
+      v >>= 32;
+    }
+  }
+
+  bool is_zero() const {
+    return limbs.empty();
+  }
+
+  size_t num_bytes() const {
+    return limbs.size() * sizeof(uint32_t);
+  }
+
+  bigcount& operator+=(const bigcount& rhs) {
+    if (limbs.size() < rhs.limbs.size()) limbs.resize(rhs.limbs.size(), 0);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < limbs.size(); i++) {
+      uint64_t sum = carry + limbs[i] + (i < rhs.limbs.size() ? rhs.limbs[i] : 0);
+      limbs[i] = static_cast<uint32_t>(sum);
+      carry = sum >> 32;
+    }
+    if (carry) limbs.push_back(static_cast<uint32_t>(carry));
+    return *this;
+  }
+
+  bigcount operator*(const bigcount& rhs) const {
+    bigcount result;
+    if (is_zero() || rhs.is_zero()) return result;
+    result.limbs.assign(limbs.size() + rhs.limbs.size(), 0);
+    for (size_t i = 0; i < limbs.size(); i++) {
+      uint64_t carry = 0;
+      for (size_t j = 0; j < rhs.limbs.size(); j++) {
+        uint64_t cur = result.limbs[i + j] + carry +
+                       static_cast<uint64_t>(limbs[i]) * rhs.limbs[j];
+        result.limbs[i + j] = static_cast<uint32_t>(cur);
+        carry = cur >> 32;
+      }
+      result.limbs[i + rhs.limbs.size()] += static_cast<uint32_t>(carry);
+    }
+    result.trim();
+    return result;
+  }
+
+  bigcount& operator*=(const bigcount& rhs) {
+    *this = *this * rhs;
+    return *this;
+  }
+
+  // multiply by 2^k
+  void shift_left(size_t k) {
+    if (is_zero() || k == 0) return;
+    size_t words = k / 32;
+    unsigned bits = k % 32;
+    if (bits) {
+      uint32_t carry = 0;
+      for (size_t i = 0; i < limbs.size(); i++) {
+        uint32_t next = limbs[i] >> (32 - bits);
+        limbs[i] = (limbs[i] << bits) | carry;
+        carry = next;
+      }
+      if (carry) limbs.push_back(carry);
+    }
+    limbs.insert(limbs.begin(), words, 0);
+  }
+
+  std::string to_string() const {
+    if (is_zero()) return "0";
+    // repeated division by 10^9
+    std::vector<uint32_t> rest(limbs);
+    std::vector<uint32_t> chunks;
+    while (!rest.empty()) {
+      uint64_t rem = 0;
+      for (size_t i = rest.size(); i-- > 0;) {
+        uint64_t cur = (rem << 32) | rest[i];
+        rest[i] = static_cast<uint32_t>(cur / 1000000000);
+        rem = cur % 1000000000;
+      }
+      chunks.push_back(static_cast<uint32_t>(rem));
+      while (!rest.empty() && rest.back() == 0) rest.pop_back();
+    }
+
+    std::string s = std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+      std::string part = std::to_string(chunks[i]);
+      s += std::string(9 - part.size(), '0') + part;
+    }
+    return s;
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const bigcount& b) {
+    os << b.to_string();
+    return os;
+  }
+};
+
+#endif /* BIGCOUNT_H */
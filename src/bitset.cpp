@@ -0,0 +1,229 @@
+#include <cstdint>
+#include <vector>
+
+#include "bitset.h"
+
+template <int W>
+struct bitmask {
+  uint64_t w[W];
+
+  void clear() {
+    for (int i = 0; i < W; i++) w[i] = 0;
+  }
+
+  void set(var v) {
+    w[v >> 6] |= uint64_t(1) << (v & 63);
+  }
+
+  bool test(var v) const {
+    return (w[v >> 6] >> (v & 63)) & 1;
+  }
+};
+
+// a clause is the pair (pos, neg), as is the assignment (tru, fls)
+template <int W>
+struct bitset_clause {
+  bitmask<W> pos;
+  bitmask<W> neg;
+};
+
+// outcome of a clause under an assignment
+enum bitset_status {bsat, bopen, bunit, bconflict};
+
+template <int W>
+class bitset_engine {
+  std::vector<bitset_clause<W> > clauses;
+
+  // the variables set true and set false
+  bitmask<W> tru;
+  bitmask<W> fls;
+
+  struct frame {
+    bitmask<W> tru;
+    bitmask<W> fls;
+    size_t first_open;
+    var v;
+    bool value;
+    bool flipped;
+  };
+
+  // clause -> index in clauses, grouped by literal as a CSR array
+  std::vector<uint32_t> occurs_start;
+  std::vector<uint32_t> occurs;
+  // literals made false and not yet propagated
+  std::vector<lit> queue;
+  size_t first_open;
+
+  template <typename F>
+  static void for_each_literal(const bitset_clause<W> &C, F f) {
+    for (int i = 0; i < W; i++) {
+      for (uint64_t m = C.pos.w[i]; m; m &= m - 1) f(mk_lit(i * 64 + __builtin_ctzll(m), true));
+      for (uint64_t m = C.neg.w[i]; m; m &= m - 1) f(mk_lit(i * 64 + __builtin_ctzll(m), false));
+    }
+  }
+
+  void assign(var v, bool value) {
+    if (value) tru.set(v);
+    else fls.set(v);
+    queue.push_back(mk_lit(v, !value));
+  }
+
+  // for a unit clause, *v and *value make it true; for an open one they
+  // are its first open literal; otherwise *v is -1
+  bitset_status evaluate(const bitset_clause<W> &C, var *v, bool *value) const {
+    *v = -1;
+    *value = false;
+    uint64_t satisfied = 0;
+    int open = 0;
+    int first = -1;
+    for (int i = 0; i < W; i++) {
+      satisfied |= (C.pos.w[i] & tru.w[i]) | (C.neg.w[i] & fls.w[i]);
+      uint64_t unassigned = ~(tru.w[i] | fls.w[i]);
+      uint64_t open_pos = C.pos.w[i] & unassigned;
+      uint64_t open_neg = C.neg.w[i] & unassigned;
+      open += __builtin_popcountll(open_pos) + __builtin_popcountll(open_neg);
+      if (first < 0 && (open_pos | open_neg)) {
+        // the lowest open variable, positive if it occurs so
+        uint64_t low = (open_pos | open_neg) & -(open_pos | open_neg);
+        first = i * 64 + __builtin_ctzll(low);
+        *value = (open_pos & low) != 0;
+      }
+    }
+    if (satisfied) return bsat;
+    if (open == 0) return bconflict;
+    *v = first;
+    return open == 1 ? bunit : bopen;
+  }
+
+  // evaluates the clauses of the literals made false since the last call,
+  // assigning their units in turn; false on a conflict
+  bool propagate() {
+    while (!queue.empty()) {
+      lit falsified = queue.back();
+      queue.pop_back();
+      for (uint32_t i = occurs_start[falsified]; i < occurs_start[falsified + 1]; i++) {
+        var v;
+        bool value;
+        switch (evaluate(clauses[occurs[i]], &v, &value)) {
+          case bconflict:
+            queue.clear();
+            return false;
+          case bunit:
+            assign(v, value);
+            break;
+          default:
+            break;
+        }
+      }
+    }
+    return true;
+  }
+
+  // the first open literal of the first open clause, as decide() picks it.
+  // the clauses before first_open were satisfied by an assignment this one
+  // extends, the search restores it on backtracking.
+  bool decide(var *v, bool *value) {
+    for (; first_open < clauses.size(); first_open++) {
+      if (evaluate(clauses[first_open], v, value) == bopen) return true;
+    }
+    return false;
+  }
+
+public:
+  // tautologies are left out, the masks cannot tell them from units
+  bitset_engine(CNF *cnf, int num_vars) : occurs_start(2 * num_vars + 1, 0), first_open(0) {
+    tru.clear();
+    fls.clear();
+    clauses.reserve(cnf->clauses.size());
+    for (auto C = cnf->clauses.begin(); C != cnf->clauses.end(); C++) {
+      bitset_clause<W> B;
+      B.pos.clear();
+      B.neg.clear();
+      bool tautology = false;
+      for (auto L = (*C)->literals.begin(); L != (*C)->literals.end(); L++) {
+        var v = lit_var(*L);
+        if (lit_is_pos(*L)) B.pos.set(v);
+        else B.neg.set(v);
+        if (B.pos.test(v) && B.neg.test(v)) tautology = true;
+      }
+      if (!tautology) clauses.push_back(B);
+    }
+
+    // every clause is listed once under each of its literals
+    for (auto B = clauses.begin(); B != clauses.end(); B++) {
+      for_each_literal(*B, [&](lit L) { occurs_start[L + 1]++; });
+    }
+    for (size_t L = 0; L + 1 < occurs_start.size(); L++) occurs_start[L + 1] += occurs_start[L];
+    occurs.resize(occurs_start.back());
+    std::vector<uint32_t> fill(occurs_start.begin(), occurs_start.end() - 1);
+    for (uint32_t c = 0; c < clauses.size(); c++) {
+      for_each_literal(clauses[c], [&](lit L) { occurs[fill[L]++] = c; });
+    }
+  }
+
+  solve_result solve(dpll_budget &budget) {
+    std::vector<frame> decisions;
+
+    // the units of the input start the queue
+    bool ok = true;
+    for (auto C = clauses.begin(); C != clauses.end() && ok; C++) {
+      var v;
+      bool value;
+      bitset_status status = evaluate(*C, &v, &value);
+      if (status == bconflict) ok = false;
+      else if (status == bunit) assign(v, value);
+    }
+    ok = ok && propagate();
+
+    while (true) {
+      if (budget.exhausted(decisions.size())) return runknown;
+
+      if (!ok) {
+        budget.stats.conflicts++;
+        // chronological backtracking to the last decision not yet flipped
+        while (!decisions.empty() && decisions.back().flipped) decisions.pop_back();
+        if (decisions.empty()) return runsat;
+        frame &f = decisions.back();
+        tru = f.tru;
+        fls = f.fls;
+        first_open = f.first_open;
+        f.value = !f.value;
+        f.flipped = true;
+        assign(f.v, f.value);
+        ok = propagate();
+        continue;
+      }
+
+      var v;
+      bool value;
+      if (!decide(&v, &value)) return rsat;
+      budget.stats.decisions++;
+      frame f = {tru, fls, first_open, v, value, false};
+      decisions.push_back(f);
+      assign(v, value);
+      ok = propagate();
+    }
+  }
+
+  void model(int num_vars, assignment &result) const {
+    result.assign(num_vars, true);
+    for (var v = 0; v < num_vars; v++) {
+      if (fls.test(v)) result[v] = false;
+    }
+  }
+};
+
+template <int W>
+static solve_result bitset_solve_words(CNF *cnf, int num_vars, dpll_budget &budget,
+                                       assignment &result) {
+  bitset_engine<W> engine(cnf, num_vars);
+  solve_result res = engine.solve(budget);
+  if (res == rsat) engine.model(num_vars, result);
+  return res;
+}
+
+solve_result bitset_solve(CNF *cnf, int num_vars, dpll_budget &budget, assignment &result) {
+  if (num_vars <= 64) return bitset_solve_words<1>(cnf, num_vars, budget, result);
+  if (num_vars <= 128) return bitset_solve_words<2>(cnf, num_vars, budget, result);
+  return bitset_solve_words<4>(cnf, num_vars, budget, result);
+}
@@ -0,0 +1,24 @@
+#ifndef BITSET_H
+#define BITSET_H
+
+#include "cnf.h"
+#include "dpll.h"
+
+// largest instance the bitset engine takes
+#define BITSET_MAX_VARS 256
+
+// DPLL for instances of at most BITSET_MAX_VARS variables, specialized on
+// the number of 64-bit words their variables take (1, 2 or 4). A clause is
+// a pair of masks, its positive and its negative variables, and so is the
+// assignment, the variables set true and those set false. A clause is
+// evaluated with a few word-wide ANDs and popcounts and a decision saves
+// the assignment by value. Its allocations are made up front or grow
+// with the search depth: the clause list, the clause occurrences per
+// literal, the propagation queue and a frame per decision. Like dpll_solve it decides on the first open clause and backtracks
+// chronologically, but it has no pure literal rule.
+//
+// Variables left open are set to true in result. The limits and control
+// of budget apply.
+solve_result bitset_solve(CNF *cnf, int num_vars, dpll_budget &budget, assignment &result);
+
+#endif /* BITSET_H */
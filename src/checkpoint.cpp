@@ -0,0 +1,109 @@
+#include <cstdio>
+#include <cstring>
+
+#include "checkpoint.h"
+
+#define SNAPSHOT_MAGIC "DPLLSNAP"
+#define SNAPSHOT_MAGIC_BYTES 8
+#define SNAPSHOT_VERSION 1
+
+// FNV-1a, 64 bit
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+static uint64_t fnv_add(uint64_t h, uint32_t x) {
+  for (int i = 0; i < 4; i++) {
+    h ^= (x >> (8 * i)) & 0xff;
+    h *= FNV_PRIME;
+  }
+  return h;
+}
+
+uint64_t cnf_fingerprint(CNF *cnf, int num_vars) {
+  uint64_t h = fnv_add(FNV_OFFSET, num_vars);
+  for (auto C = cnf->clauses.begin(); C != cnf->clauses.end(); C++) {
+    h = fnv_add(h, (*C)->literals.size());
+    for (auto L = (*C)->literals.begin(); L != (*C)->literals.end(); L++) h = fnv_add(h, *L);
+  }
+  return h;
+}
+
+template <typename T>
+static bool put(FILE *file, const T &x) {
+  return std::fwrite(&x, sizeof(T), 1, file) == 1;
+}
+
+template <typename T>
+static bool get(FILE *file, T &x) {
+  return std::fread(&x, sizeof(T), 1, file) == 1;
+}
+
+bool write_snapshot(const std::string &path, const dpll_snapshot &snapshot) {
+  std::string tmp = path + ".tmp";
+  FILE *file = std::fopen(tmp.c_str(), "wb");
+  if (!file) return false;
+
+  bool ok = std::fwrite(SNAPSHOT_MAGIC, 1, SNAPSHOT_MAGIC_BYTES, file) == SNAPSHOT_MAGIC_BYTES;
+  ok = ok && put(file, static_cast<uint32_t>(SNAPSHOT_VERSION));
+  ok = ok && put(file, snapshot.cnf_hash);
+  ok = ok && put(file, static_cast<int32_t>(snapshot.num_vars));
+  ok = ok && put(file, snapshot.decisions);
+  ok = ok && put(file, snapshot.conflicts);
+  ok = ok && put(file, snapshot.pure_literals);
+  ok = ok && put(file, static_cast<uint32_t>(snapshot.levels.size()));
+  for (auto l = snapshot.levels.begin(); ok && l != snapshot.levels.end(); l++) {
+    ok = put(file, static_cast<int32_t>(l->var));
+    ok = ok && put(file, static_cast<uint8_t>(l->asmt));
+    ok = ok && put(file, static_cast<uint8_t>(l->flipped));
+    ok = ok && put(file, static_cast<uint32_t>(l->props.size()));
+    if (ok && !l->props.empty()) {
+      ok = std::fwrite(l->props.data(), sizeof(lit), l->props.size(), file) == l->props.size();
+    }
+  }
+
+  ok = std::fclose(file) == 0 && ok;
+  ok = ok && std::rename(tmp.c_str(), path.c_str()) == 0;
+  if (!ok) std::remove(tmp.c_str());
+  return ok;
+}
+
+bool read_snapshot(const std::string &path, dpll_snapshot &snapshot) {
+  FILE *file = std::fopen(path.c_str(), "rb");
+  if (!file) return false;
+
+  char magic[SNAPSHOT_MAGIC_BYTES];
+  uint32_t version, num_levels;
+  int32_t num_vars;
+  bool ok = std::fread(magic, 1, SNAPSHOT_MAGIC_BYTES, file) == SNAPSHOT_MAGIC_BYTES &&
+    std::memcmp(magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_BYTES) == 0;
+  ok = ok && get(file, version) && version == SNAPSHOT_VERSION;
+  ok = ok && get(file, snapshot.cnf_hash) && get(file, num_vars);
+  ok = ok && get(file, snapshot.decisions) && get(file, snapshot.conflicts);
+  ok = ok && get(file, snapshot.pure_literals) && get(file, num_levels);
+  snapshot.num_vars = num_vars;
+
+  snapshot.levels.clear();
+  for (uint32_t i = 0; ok && i < num_levels; i++) {
+    dpll_snapshot::level l;
+    int32_t v;
+    uint8_t asmt, flipped;
+    uint32_t num_props;
+    ok = get(file, v) && get(file, asmt) && get(file, flipped) && get(file, num_props);
+    // only the level below the first decision has no variable, and every
+    // variable is assigned at most once
+    ok = ok && v >= (i == 0 ? -1 : 0) && v < num_vars &&
+         num_props <= static_cast<uint32_t>(num_vars);
+    if (!ok) break;
+    l.var = v;
+    l.asmt = asmt;
+    l.flipped = flipped;
+    l.props.resize(num_props);
+    if (num_props) ok = std::fread(l.props.data(), sizeof(lit), num_props, file) == num_props;
+    for (auto L = l.props.begin(); ok && L != l.props.end(); L++) ok = lit_var(*L) < num_vars;
+    snapshot.levels.push_back(l);
+  }
+
+  std::fclose(file);
+  // the level below the first decision is always there
+  return ok && !snapshot.levels.empty() && snapshot.levels[0].var == -1;
+}
@@ -0,0 +1,48 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cnf.h"
+
+// The state of a DPLL search between two iterations: the stack of
+// decisions, each with whether its other branch has been refuted already
+// and the literals assigned under it, sorted by variable as the search
+// keeps them. Replay sets a level's literals before anything propagates
+// them, so their order does not matter. The top decision has just
+// been made and not yet propagated. The search heuristics are fixed
+// functions of the assignment and nothing is learned, so the trail is all
+// there is to resume from; the effort counters are kept for the
+// statistics and limits.
+struct dpll_snapshot {
+  struct level {
+    // -1 for the level below the first decision
+    int var;
+    bool asmt;
+    bool flipped;
+    std::vector<lit> props;
+  };
+
+  // the CNF the search runs on, see cnf_fingerprint
+  uint64_t cnf_hash;
+  int num_vars;
+  uint64_t decisions;
+  uint64_t conflicts;
+  uint64_t pure_literals;
+  std::vector<level> levels;
+};
+
+// a hash of the clauses of cnf in order, to tell whether a snapshot was
+// taken on the same search
+uint64_t cnf_fingerprint(CNF *cnf, int num_vars);
+
+// Snapshots are binary, in native byte order, a few bytes per assigned
+// variable. A snapshot is written next to path and renamed over it, so an
+// interrupted write leaves the previous one intact. Both return false on
+// failure; read also on a file that is not a snapshot.
+bool write_snapshot(const std::string &path, const dpll_snapshot &snapshot);
+bool read_snapshot(const std::string &path, dpll_snapshot &snapshot);
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,493 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "circuit.h"
+
+// initial size of the gate table, a power of two
+#define CIRCUIT_INITIAL_SLOTS 1024
+
+// value of an unassigned node
+#define UNASSIGNED -1
+
+enum gate_kind {input_gate, true_gate, and_gate, xor_gate, atleast_gate};
+
+// A node of the circuit. Edges are literals over node ids, so a negated
+// edge costs nothing. & is n-ary, | and -> are & with negated edges, <->
+// is a negated xor, and atmost and exactly are built from atleast gates.
+struct gate {
+  gate_kind kind;
+  // bound of an atleast gate
+  int k;
+  // the operands are operands[first .. first + count)
+  uint32_t first;
+  uint32_t count;
+};
+
+// what changed at a gate, so that rules that need a scan of its operands
+// only run when the change can enable them
+enum gate_event {output_changed, operand_true, operand_false};
+
+// a decision on a primary input, with the state to return to
+struct circuit_decision {
+  var input;
+  bool value;
+  bool flipped;
+  size_t trail_size;
+  size_t frontier;
+};
+
+class circuit {
+  int num_inputs;
+  std::vector<gate> gates;
+  std::vector<lit> operands;
+  std::vector<uint64_t> hashes;
+  // open-addressing table of gate ids by hash, -1 if empty
+  std::vector<int> slots;
+  size_t slot_mask;
+
+  // gates reading each node, as literals over the gate with the sign of
+  // the edge
+  std::vector<uint32_t> fanout_start;
+  std::vector<lit> fanout;
+
+  std::vector<int8_t> value;
+  // operands of and and atleast gates known true and known false, counting
+  // the nodes propagation has gone past
+  std::vector<uint32_t> num_true;
+  std::vector<uint32_t> num_false;
+  std::vector<var> trail;
+  size_t qhead;
+
+  const lit *ops(const gate &g) const {
+    return &operands[g.first];
+  }
+
+  static uint64_t hash_of(gate_kind kind, int k, const lit *ops, size_t n) {
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h](uint32_t x) {
+      h ^= x;
+      h *= 1099511628211ULL;
+    };
+    mix(kind);
+    mix(k);
+    for (size_t i = 0; i < n; i++) mix(ops[i]);
+    return h;
+  }
+
+  bool same(const gate &g, gate_kind kind, int k, const lit *o, size_t n) const {
+    return g.kind == kind && g.k == k && g.count == n && std::equal(o, o + n, ops(g));
+  }
+
+  void grow() {
+    std::vector<int> old_slots(slots.size() * 2, -1);
+    old_slots.swap(slots);
+    slot_mask = slots.size() - 1;
+    for (auto it = old_slots.begin(); it != old_slots.end(); it++) {
+      if (*it < 0) continue;
+      size_t i = (hashes[*it] * 11400714819323198485ULL) >> 32 & slot_mask;
+      while (slots[i] >= 0) i = (i + 1) & slot_mask;
+      slots[i] = *it;
+    }
+  }
+
+  // the gate with these operands, made if there is none yet
+  lit intern(gate_kind kind, int k, const std::vector<lit> &o) {
+    uint64_t h = hash_of(kind, k, o.data(), o.size());
+    size_t i = (h * 11400714819323198485ULL) >> 32 & slot_mask;
+    while (slots[i] >= 0) {
+      int id = slots[i];
+      if (hashes[id] == h && same(gates[id], kind, k, o.data(), o.size())) {
+        shared++;
+        return mk_lit(id, true);
+      }
+      i = (i + 1) & slot_mask;
+    }
+
+    gate g = {kind, k, static_cast<uint32_t>(operands.size()), static_cast<uint32_t>(o.size())};
+    operands.insert(operands.end(), o.begin(), o.end());
+    slots[i] = gates.size();
+    gates.push_back(g);
+    hashes.push_back(h);
+    if (2 * gates.size() > slots.size()) grow();
+    return mk_lit(gates.size() - 1, true);
+  }
+
+  lit mk_and(std::vector<lit> &o) {
+    std::sort(o.begin(), o.end());
+    o.erase(std::unique(o.begin(), o.end()), o.end());
+    std::vector<lit> kept;
+    for (size_t i = 0; i < o.size(); i++) {
+      if (o[i] == false_lit) return false_lit;
+      if (o[i] == true_lit) continue;
+      // x and !x are next to each other once sorted
+      if (i + 1 < o.size() && o[i + 1] == lit_neg(o[i])) return false_lit;
+      kept.push_back(o[i]);
+    }
+    if (kept.empty()) return true_lit;
+    if (kept.size() == 1) return kept[0];
+    return intern(and_gate, 0, kept);
+  }
+
+  lit mk_or(std::vector<lit> &o) {
+    for (auto it = o.begin(); it != o.end(); it++) *it = lit_neg(*it);
+    return lit_neg(mk_and(o));
+  }
+
+  lit mk_xor(lit a, lit b) {
+    if (lit_var(a) == lit_var(true_lit)) std::swap(a, b);
+    if (lit_var(b) == lit_var(true_lit)) return b == true_lit ? lit_neg(a) : a;
+    if (a == b) return false_lit;
+    if (a == lit_neg(b)) return true_lit;
+    // the negations move to the output: !a ^ b = !(a ^ b)
+    bool negated = lit_is_pos(a) != lit_is_pos(b);
+    std::vector<lit> o = {mk_lit(std::min(lit_var(a), lit_var(b)), true),
+                          mk_lit(std::max(lit_var(a), lit_var(b)), true)};
+    lit x = intern(xor_gate, 0, o);
+    return negated ? lit_neg(x) : x;
+  }
+
+  lit mk_atleast(std::vector<lit> o, int k) {
+    std::vector<lit> kept;
+    for (auto it = o.begin(); it != o.end(); it++) {
+      if (*it == true_lit) k--;
+      else if (*it != false_lit) kept.push_back(*it);
+    }
+    if (k <= 0) return true_lit;
+    if (k > static_cast<int>(kept.size())) return false_lit;
+    if (k == static_cast<int>(kept.size())) return mk_and(kept);
+    if (k == 1) return mk_or(kept);
+    std::sort(kept.begin(), kept.end());
+    return intern(atleast_gate, k, kept);
+  }
+
+  // operands of a chain of op, in order
+  static void collect_chain(Formula *f, Connective op, std::vector<Formula *> &out) {
+    std::vector<Formula *> stack(1, f);
+    while (!stack.empty()) {
+      Formula *g = stack.back();
+      stack.pop_back();
+      Binary *b = static_cast<Binary *>(g);
+      if (g->type == Formula::binary && b->op == op) {
+        stack.push_back(b->r);
+        stack.push_back(b->l);
+      } else {
+        out.push_back(g);
+      }
+    }
+  }
+
+  int value_of_lit(lit l) const {
+    int8_t v = value[lit_var(l)];
+    if (v == UNASSIGNED) return UNASSIGNED;
+    return v == lit_is_pos(l);
+  }
+
+  // makes l true, false on a conflict
+  bool assign(lit l) {
+    int8_t v = value[lit_var(l)];
+    if (v != UNASSIGNED) return v == lit_is_pos(l);
+    value[lit_var(l)] = lit_is_pos(l);
+    trail.push_back(lit_var(l));
+    return true;
+  }
+
+  // the first unassigned operand of g, or the constant if there is none
+  lit open_operand(const gate &g) const {
+    for (uint32_t i = 0; i < g.count; i++) {
+      if (value_of_lit(ops(g)[i]) == UNASSIGNED) return ops(g)[i];
+    }
+    return true_lit;
+  }
+
+  // sets every unassigned operand of g to polarity
+  bool assign_open(const gate &g, bool polarity) {
+    for (uint32_t i = 0; i < g.count; i++) {
+      lit o = ops(g)[i];
+      if (value_of_lit(o) == UNASSIGNED && !assign(polarity ? o : lit_neg(o))) return false;
+    }
+    return true;
+  }
+
+  // Applies the semantics of gate id to what is known about its output and
+  // operands, forward and backward. Returns false on a conflict.
+  bool check(var id, gate_event event) {
+    const gate &g = gates[id];
+    lit out = mk_lit(id, true);
+    switch (g.kind) {
+      case input_gate:
+      case true_gate:
+        return true;
+
+      case and_gate: {
+        if (num_false[id] > 0) return assign(lit_neg(out));
+        if (num_true[id] == g.count) return assign(out);
+        // the operands are all set when the output turns true
+        if (value[id] == 1 && event == output_changed) return assign_open(g, true);
+        if (value[id] == 0 && num_true[id] + 1 == g.count) {
+          lit o = open_operand(g);
+          if (o != true_lit) return assign(lit_neg(o));
+        }
+        return true;
+      }
+
+      case xor_gate: {
+        int a = value_of_lit(ops(g)[0]);
+        int b = value_of_lit(ops(g)[1]);
+        if (a != UNASSIGNED && b != UNASSIGNED) return assign(a != b ? out : lit_neg(out));
+        if (value[id] == UNASSIGNED || (a == UNASSIGNED && b == UNASSIGNED)) return true;
+        // the open operand is out ^ the known one
+        lit open = a == UNASSIGNED ? ops(g)[0] : ops(g)[1];
+        bool known = a == UNASSIGNED ? b : a;
+        return assign(value[id] != known ? open : lit_neg(open));
+      }
+
+      case atleast_gate: {
+        int n = g.count, k = g.k;
+        int t = num_true[id], f = num_false[id];
+        if (t >= k) return assign(out);
+        if (n - f < k) return assign(lit_neg(out));
+        if (value[id] == 1 && n - f == k && event != operand_true) return assign_open(g, true);
+        if (value[id] == 0 && t == k - 1 && event != operand_false) return assign_open(g, false);
+        return true;
+      }
+    }
+    return true;
+  }
+
+  // Whether the value of gate id follows from its assigned operands alone,
+  // whatever the open ones become. Only called with propagation done.
+  bool justified(var id) const {
+    const gate &g = gates[id];
+    switch (g.kind) {
+      case input_gate:
+      case true_gate:
+        return true;
+      case and_gate:
+        return value[id] == 1 || num_false[id] > 0;
+      case xor_gate:
+        return value_of_lit(ops(g)[0]) != UNASSIGNED && value_of_lit(ops(g)[1]) != UNASSIGNED;
+      case atleast_gate:
+        if (value[id] == 1) return static_cast<int>(num_true[id]) >= g.k;
+        return static_cast<int>(g.count - num_false[id]) < g.k;
+    }
+    return true;
+  }
+
+  // Follows open operands down from the unjustified gate id to a primary
+  // input, choosing at every gate the operand value that helps explain the
+  // value wanted of it. Returns the input literal to decide.
+  lit backtrace(var id) const {
+    lit want = mk_lit(id, value[id] == 1);
+    while (gates[lit_var(want)].kind != input_gate) {
+      const gate &g = gates[lit_var(want)];
+      bool wanted = lit_is_pos(want);
+      lit o = open_operand(g);
+      switch (g.kind) {
+        case and_gate:
+        case atleast_gate:
+          // & and atleast need more true operands to be true, false ones
+          // to be false
+          want = wanted ? o : lit_neg(o);
+          break;
+        case xor_gate: {
+          lit other = o == ops(g)[0] ? ops(g)[1] : ops(g)[0];
+          bool known = value_of_lit(other) == 1;
+          want = wanted != known ? o : lit_neg(o);
+          break;
+        }
+        default:
+          break;
+      }
+    }
+    return want;
+  }
+
+  void undo_to(size_t size) {
+    while (trail.size() > size) {
+      var node = trail.back();
+      if (trail.size() <= qhead) {
+        for (uint32_t i = fanout_start[node]; i < fanout_start[node + 1]; i++) {
+          var g = lit_var(fanout[i]);
+          if (value[node] == lit_is_pos(fanout[i])) num_true[g]--;
+          else num_false[g]--;
+        }
+      }
+      value[node] = UNASSIGNED;
+      trail.pop_back();
+    }
+    if (qhead > size) qhead = size;
+  }
+
+  bool propagate() {
+    while (qhead < trail.size()) {
+      var node = trail[qhead++];
+      // count first, so that undo_to can take back the whole node
+      for (uint32_t i = fanout_start[node]; i < fanout_start[node + 1]; i++) {
+        var g = lit_var(fanout[i]);
+        if (value[node] == lit_is_pos(fanout[i])) num_true[g]++;
+        else num_false[g]++;
+      }
+      for (uint32_t i = fanout_start[node]; i < fanout_start[node + 1]; i++) {
+        gate_event event = value[node] == lit_is_pos(fanout[i]) ? operand_true : operand_false;
+        if (!check(lit_var(fanout[i]), event)) return false;
+      }
+      if (!check(node, output_changed)) return false;
+    }
+    return true;
+  }
+
+public:
+  lit true_lit;
+  lit false_lit;
+  // gates found again by structural hashing
+  size_t shared;
+
+  circuit(int n) : num_inputs(n), slots(CIRCUIT_INITIAL_SLOTS, -1),
+    slot_mask(CIRCUIT_INITIAL_SLOTS - 1), qhead(0), shared(0) {
+    gate input = {input_gate, 0, 0, 0};
+    gates.assign(n, input);
+    hashes.assign(n, 0);
+    gate t = {true_gate, 0, 0, 0};
+    gates.push_back(t);
+    hashes.push_back(0);
+    true_lit = mk_lit(n, true);
+    false_lit = lit_neg(true_lit);
+  }
+
+  size_t num_gates() const {
+    return gates.size() - num_inputs - 1;
+  }
+
+  // the edge computing f
+  lit build(Formula *f) {
+    switch (f->type) {
+      case Formula::variable:
+        return mk_lit(static_cast<Variable *>(f)->var, true);
+
+      case Formula::negated:
+        return lit_neg(build(static_cast<Negated *>(f)->f));
+
+      case Formula::binary: {
+        Binary *b = static_cast<Binary *>(f);
+        if (b->op == land || b->op == lor) {
+          std::vector<Formula *> chain;
+          collect_chain(f, b->op, chain);
+          std::vector<lit> o;
+          o.reserve(chain.size());
+          for (auto it = chain.begin(); it != chain.end(); it++) o.push_back(build(*it));
+          return b->op == land ? mk_and(o) : mk_or(o);
+        }
+        lit l = build(b->l);
+        lit r = build(b->r);
+        if (b->op == lequiv) return lit_neg(mk_xor(l, r));
+        std::vector<lit> o = {lit_neg(l), r};
+        return mk_or(o);
+      }
+
+      case Formula::cardinality: {
+        Cardinality *c = static_cast<Cardinality *>(f);
+        std::vector<lit> o;
+        for (auto it = c->operands.begin(); it != c->operands.end(); it++) o.push_back(build(*it));
+        switch (c->bound) {
+          case atleast:
+            return mk_atleast(o, c->k);
+          case atmost:
+            return lit_neg(mk_atleast(o, c->k + 1));
+          case exactly: {
+            std::vector<lit> both = {mk_atleast(o, c->k), lit_neg(mk_atleast(o, c->k + 1))};
+            return mk_and(both);
+          }
+        }
+      }
+    }
+    return true_lit;
+  }
+
+  // indexes the fanout of every node, once the circuit is complete
+  void finish() {
+    size_t n = gates.size();
+    fanout_start.assign(n + 1, 0);
+    for (size_t id = 0; id < n; id++) {
+      for (uint32_t i = 0; i < gates[id].count; i++) fanout_start[lit_var(ops(gates[id])[i]) + 1]++;
+    }
+    for (size_t id = 0; id < n; id++) fanout_start[id + 1] += fanout_start[id];
+    fanout.resize(fanout_start[n]);
+    std::vector<uint32_t> fill(fanout_start.begin(), fanout_start.end() - 1);
+    for (size_t id = 0; id < n; id++) {
+      for (uint32_t i = 0; i < gates[id].count; i++) {
+        lit o = ops(gates[id])[i];
+        fanout[fill[lit_var(o)]++] = mk_lit(id, lit_is_pos(o));
+      }
+    }
+    value.assign(n, UNASSIGNED);
+    num_true.assign(n, 0);
+    num_false.assign(n, 0);
+  }
+
+  solve_result search(lit root, dpll_budget &budget, assignment &result) {
+    std::vector<circuit_decision> decisions;
+    // gates on the trail before the frontier are justified
+    size_t frontier = 0;
+
+    assign(true_lit);
+    if (!assign(root)) return runsat;
+
+    while (true) {
+      if (budget.exhausted(decisions.size())) return runknown;
+
+      if (!propagate()) {
+        budget.stats.conflicts++;
+        while (true) {
+          if (decisions.empty()) return runsat;
+          circuit_decision &d = decisions.back();
+          undo_to(d.trail_size);
+          frontier = d.frontier;
+          if (!d.flipped) {
+            d.flipped = true;
+            d.value = !d.value;
+            assign(mk_lit(d.input, d.value));
+            break;
+          }
+          decisions.pop_back();
+        }
+        continue;
+      }
+
+      while (frontier < trail.size() && justified(trail[frontier])) frontier++;
+      if (frontier == trail.size()) break;
+
+      lit decision = backtrace(trail[frontier]);
+      budget.stats.decisions++;
+      circuit_decision d = {lit_var(decision), lit_is_pos(decision), false, trail.size(), frontier};
+      decisions.push_back(d);
+      assign(decision);
+    }
+
+    result.assign(num_inputs, true);
+    for (var v = 0; v < num_inputs; v++) {
+      if (value[v] != UNASSIGNED) result[v] = value[v];
+    }
+    return rsat;
+  }
+};
+
+solve_result circuit_solve(Formula *f, int num_inputs, const dpll_options &opts,
+                           dpll_stats &stats, assignment &result, std::ostream &output_pref,
+                           dpll_control *control) {
+  dpll_budget budget(opts.limits, control, stats);
+
+  circuit *C = new circuit(num_inputs);
+  lit root = C->build(f);
+  C->finish();
+  output_pref << "Built a circuit of " << C->num_gates() << " gates over " << num_inputs
+              << " inputs, " << C->shared << " repeated subformulas shared" << std::endl;
+
+  solve_result res = C->search(root, budget, result);
+
+  stats.seconds = budget.elapsed();
+  stats.peak_memory_bytes = peak_memory_bytes();
+  delete C;
+  return res;
+}
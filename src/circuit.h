@@ -0,0 +1,24 @@
+#ifndef CIRCUIT_H
+#define CIRCUIT_H
+
+#include <ostream>
+
+#include "dpll.h"
+#include "formula.h"
+
+// Solves f on its circuit instead of a CNF. The formula becomes an
+// and-inverter graph with xor and at-least-k gates, structurally hashed so
+// that repeated subformulas are one gate. Gates propagate through their
+// semantics in both directions, and decisions come from justification:
+// the first gate whose value is not yet explained by its operands is
+// traced back to an unassigned primary input, the only variables the
+// search ever decides. No auxiliary variables are introduced.
+//
+// The model covers the num_inputs primary inputs, inputs left open are
+// set to true. The limits and the control of opts and control apply as in
+// dpll_solve.
+solve_result circuit_solve(Formula *f, int num_inputs, const dpll_options &opts,
+                           dpll_stats &stats, assignment &result, std::ostream &output_pref,
+                           dpll_control *control = nullptr);
+
+#endif /* CIRCUIT_H */
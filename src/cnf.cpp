@@ -19,4 +19,11 @@ Clause *merge_clause(Clause *C_A, Clause *C_B) {
   merge_vectors(C_A->literals, C_B->literals);
   delete C_B;
   return C_A;
-}
\ No newline at end of file
+}
+
+void free_cnf(CNF *cnf) {
+  for (auto C = cnf->clauses.begin(); C != cnf->clauses.end(); C++) {
+    delete *C;
+  }
+  delete cnf;
+}
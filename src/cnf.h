@@ -1,29 +1,37 @@
 #ifndef CNF_H
 #define CNF_H
 
+#include <cstdint>
 #include <ostream>
 #include <vector>
 
 typedef int var;
 
-class Literal {
-public:
-  var v;
-  bool is_true;
-
-  Literal(var vv, bool is_pos) :
-    v(vv), is_true(is_pos) {}
-  friend std::ostream& operator<<(std::ostream& os, const Literal& L) {
-    if (!L.is_true) os << "!";
-    os << L.v;
-    return os;
-  }
-};
+// packed literal: 2 * var + sign, where sign is 1 for the negative literal
+typedef uint32_t lit;
+
+inline lit mk_lit(var v, bool is_pos) {
+  return (static_cast<lit>(v) << 1) | (is_pos ? 0 : 1);
+}
+inline var lit_var(lit L) {
+  return static_cast<var>(L >> 1);
+}
+inline bool lit_is_pos(lit L) {
+  return !(L & 1);
+}
+inline lit lit_neg(lit L) {
+  return L ^ 1;
+}
+
+inline void print_lit(std::ostream& os, lit L) {
+  if (!lit_is_pos(L)) os << "!";
+  os << lit_var(L);
+}
 
 // Or-Clause
 class Clause {
 public:
-  std::vector<Literal *> literals;
+  std::vector<lit> literals;
 
   Clause() {}
   friend std::ostream& operator<<(std::ostream& os, const Clause& C) {
@@ -31,11 +39,12 @@ public:
 
     if (C.literals.size() > 0) {
       auto it = C.literals.begin();
-      os << **it;
+      print_lit(os, *it);
       it++;
 
       for (; it != C.literals.end(); it++) {
-        os << "|" << **it;
+        os << "|";
+        print_lit(os, *it);
       }
     }
 
@@ -64,7 +73,28 @@ public:
   }
 };
 
+// receives clauses one at a time and takes ownership of them
+class clause_sink {
+public:
+  virtual ~clause_sink() {}
+  virtual void add_clause(Clause *C) = 0;
+};
+
+// a sink collecting the clauses into a CNF
+class cnf_builder : public clause_sink {
+public:
+  CNF *cnf;
+
+  cnf_builder() : cnf(new CNF()) {}
+  virtual void add_clause(Clause *C) {
+    cnf->clauses.push_back(C);
+  }
+};
+
 CNF *merge_cnf(CNF *CNF_A, CNF *CNF_B);
 Clause *merge_clause(Clause *C_A, Clause *C_B);
 
+// deletes cnf and all of its clauses
+void free_cnf(CNF *cnf);
+
 #endif /* CNF_H */
\ No newline at end of file
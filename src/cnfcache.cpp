@@ -0,0 +1,222 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "cnfcache.h"
+
+static const char CNF_CACHE_MAGIC[8] = {'D', 'P', 'L', 'L', 'C', 'N', 'F', '\0'};
+
+#define FLAG_USED_TSEITIN 1
+#define FLAG_SIMPLIFIED 2
+
+struct cnf_cache_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;
+  uint64_t input_hash;
+  uint64_t num_vars;
+  uint64_t num_primitive_vars;
+  uint64_t num_clauses;
+  uint64_t num_lits;
+  uint64_t names_bytes;
+  uint64_t checksum;
+};
+
+// FNV-1a over 64-bit words, then the trailing bytes
+static uint64_t checksum(const char *data, size_t len) {
+  uint64_t h = 14695981039346656037ULL;
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, data + i, 8);
+    h ^= word;
+    h *= 1099511628211ULL;
+  }
+  for (; i < len; i++) {
+    h ^= static_cast<unsigned char>(data[i]);
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+uint64_t cnf_cache_input_hash(const char *input, size_t len) {
+  return checksum(input, len);
+}
+
+// checks the mapped file and builds the entry from it
+static bool read_mapped(const char *data, size_t size, uint64_t input_hash, bool simplified,
+                        cnf_cache_entry &entry, std::string *reason) {
+  if (size < sizeof(cnf_cache_header)) {
+    *reason = "file is truncated";
+    return false;
+  }
+  const cnf_cache_header *header = reinterpret_cast<const cnf_cache_header *>(data);
+  if (std::memcmp(header->magic, CNF_CACHE_MAGIC, sizeof(CNF_CACHE_MAGIC)) != 0) {
+    *reason = "not a CNF cache file";
+    return false;
+  }
+  if (header->version != CNF_CACHE_VERSION) {
+    *reason = "cache file has a different version";
+    return false;
+  }
+  if (header->input_hash != input_hash) {
+    *reason = "cache file was made from a different input";
+    return false;
+  }
+  if (((header->flags & FLAG_SIMPLIFIED) != 0) != simplified) {
+    *reason = simplified ? "cache file was made with --no-simplify"
+                         : "cache file was made without --no-simplify";
+    return false;
+  }
+
+  size_t payload = size - sizeof(cnf_cache_header);
+  if (header->num_clauses >= payload / sizeof(uint64_t) ||
+      header->num_lits > payload / sizeof(lit) ||
+      header->names_bytes > payload ||
+      (header->num_clauses + 1) * sizeof(uint64_t) + header->num_lits * sizeof(lit) +
+        header->names_bytes != payload) {
+    *reason = "file size does not match its header";
+    return false;
+  }
+  if (checksum(data + sizeof(cnf_cache_header), payload) != header->checksum) {
+    *reason = "checksum mismatch";
+    return false;
+  }
+
+  // the sections are aligned: the header and offsets are whole 8-byte
+  // words and the file is mapped at a page boundary
+  const uint64_t *offsets = reinterpret_cast<const uint64_t *>(data + sizeof(cnf_cache_header));
+  const lit *lits = reinterpret_cast<const lit *>(offsets + header->num_clauses + 1);
+  const char *names = reinterpret_cast<const char *>(lits + header->num_lits);
+  const char *names_end = names + header->names_bytes;
+
+  if (offsets[0] != 0 || offsets[header->num_clauses] != header->num_lits) {
+    *reason = "clause offsets are corrupt";
+    return false;
+  }
+  for (uint64_t c = 0; c < header->num_clauses; c++) {
+    if (offsets[c] > offsets[c + 1]) {
+      *reason = "clause offsets are corrupt";
+      return false;
+    }
+  }
+  for (uint64_t i = 0; i < header->num_lits; i++) {
+    if (static_cast<uint64_t>(lit_var(lits[i])) >= header->num_vars) {
+      *reason = "literal out of range";
+      return false;
+    }
+  }
+
+  rmap_t *Rmap = new rmap_t();
+  Rmap->reserve(header->num_vars);
+  for (const char *name = names; name < names_end; ) {
+    const char *end = static_cast<const char *>(std::memchr(name, '\0', names_end - name));
+    if (!end) break;
+    Rmap->emplace_back(name, end - name);
+    name = end + 1;
+  }
+  if (Rmap->size() != header->num_vars || header->num_primitive_vars > header->num_vars) {
+    delete Rmap;
+    *reason = "variable names are corrupt";
+    return false;
+  }
+
+  CNF *cnf = new CNF();
+  cnf->clauses.reserve(header->num_clauses);
+  for (uint64_t c = 0; c < header->num_clauses; c++) {
+    Clause *C = new Clause();
+    C->literals.assign(lits + offsets[c], lits + offsets[c + 1]);
+    cnf->clauses.push_back(C);
+  }
+
+  entry.cnf = cnf;
+  entry.Rmap = Rmap;
+  entry.num_primitive_vars = header->num_primitive_vars;
+  entry.used_tseitin = header->flags & FLAG_USED_TSEITIN;
+  entry.simplified = header->flags & FLAG_SIMPLIFIED;
+  return true;
+}
+
+bool load_cnf_cache(const std::string &path, uint64_t input_hash, bool simplified,
+                    cnf_cache_entry &entry, std::string *reason) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    *reason = "no cache file";
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    *reason = "file is truncated";
+    return false;
+  }
+
+  size_t size = st.st_size;
+  void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    *reason = "cannot map the file";
+    return false;
+  }
+
+  bool ok = read_mapped(static_cast<const char *>(mapped), size, input_hash, simplified,
+                        entry, reason);
+  munmap(mapped, size);
+  return ok;
+}
+
+template <class T>
+static void append(std::vector<char> &buf, const T *data, size_t count) {
+  const char *bytes = reinterpret_cast<const char *>(data);
+  buf.insert(buf.end(), bytes, bytes + count * sizeof(T));
+}
+
+bool save_cnf_cache(const std::string &path, uint64_t input_hash, const cnf_cache_entry &entry) {
+  std::vector<uint64_t> offsets;
+  std::vector<lit> lits;
+  offsets.reserve(entry.cnf->clauses.size() + 1);
+  offsets.push_back(0);
+  for (auto C = entry.cnf->clauses.begin(); C != entry.cnf->clauses.end(); C++) {
+    lits.insert(lits.end(), (*C)->literals.begin(), (*C)->literals.end());
+    offsets.push_back(lits.size());
+  }
+
+  std::vector<char> payload;
+  append(payload, offsets.data(), offsets.size());
+  append(payload, lits.data(), lits.size());
+  size_t names_start = payload.size();
+  for (auto name = entry.Rmap->begin(); name != entry.Rmap->end(); name++) {
+    append(payload, name->c_str(), name->size() + 1);
+  }
+
+  cnf_cache_header header;
+  std::memcpy(header.magic, CNF_CACHE_MAGIC, sizeof(CNF_CACHE_MAGIC));
+  header.version = CNF_CACHE_VERSION;
+  header.flags = 0;
+  if (entry.used_tseitin) header.flags |= FLAG_USED_TSEITIN;
+  if (entry.simplified) header.flags |= FLAG_SIMPLIFIED;
+  header.input_hash = input_hash;
+  header.num_vars = entry.Rmap->size();
+  header.num_primitive_vars = entry.num_primitive_vars;
+  header.num_clauses = entry.cnf->clauses.size();
+  header.num_lits = lits.size();
+  header.names_bytes = payload.size() - names_start;
+  header.checksum = checksum(payload.data(), payload.size());
+
+  std::string tmp_path = path + ".tmp";
+  FILE *file = std::fopen(tmp_path.c_str(), "wb");
+  if (!file) return false;
+  bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+            std::fwrite(payload.data(), 1, payload.size(), file) == payload.size();
+  ok = std::fclose(file) == 0 && ok;
+  if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
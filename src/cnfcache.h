@@ -0,0 +1,50 @@
+#ifndef CNFCACHE_H
+#define CNFCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "cnf.h"
+#include "parser.h"
+
+// bumped whenever the file layout or the CNF produced for an input changes
+#define CNF_CACHE_VERSION 3
+
+// the final CNF of an input together with what the solver needs to report
+// models in terms of the input
+struct cnf_cache_entry {
+  CNF *cnf;
+  rmap_t *Rmap;
+  int num_primitive_vars;
+  bool used_tseitin;
+  bool simplified;  // made with the formula simplifier on
+
+  cnf_cache_entry() :
+    cnf(nullptr), Rmap(nullptr), num_primitive_vars(0), used_tseitin(false), simplified(false) {}
+};
+
+// hash of the input text a cache file was made from
+uint64_t cnf_cache_input_hash(const char *input, size_t len);
+
+// Binary cache file layout, all in native byte order:
+//
+//   header        magic, version, input hash, flags, counts, checksum
+//   offsets       uint64_t[num_clauses + 1], clause c is lits[offsets[c] ..
+//                 offsets[c+1])
+//   lits          uint32_t[num_lits], packed literals
+//   names         num_vars NUL-terminated variable names (the Rmap)
+//
+// The checksum covers everything after the header.
+
+// Maps path and copies the CNF out of it if the file is intact, has the current
+// version and was made from the input with input_hash with the simplifier
+// on or off as given by simplified. Otherwise returns false with the
+// reason in *reason.
+bool load_cnf_cache(const std::string &path, uint64_t input_hash, bool simplified,
+                    cnf_cache_entry &entry, std::string *reason);
+
+// Writes entry to path, through a temporary file that is renamed into place.
+bool save_cnf_cache(const std::string &path, uint64_t input_hash, const cnf_cache_entry &entry);
+
+#endif /* CNFCACHE_H */
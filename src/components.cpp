@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "components.h"
+
+// union-find over variables, union by size with path halving
+class var_union_find {
+  std::vector<var> parent;
+  std::vector<int> size;
+
+public:
+  var_union_find(int num_vars) : parent(num_vars), size(num_vars, 1) {
+    for (int v = 0; v < num_vars; v++) parent[v] = v;
+  }
+
+  var find(var v) {
+    while (parent[v] != v) {
+      parent[v] = parent[parent[v]];
+      v = parent[v];
+    }
+    return v;
+  }
+
+  void join(var a, var b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return;
+    if (size[a] < size[b]) std::swap(a, b);
+    parent[b] = a;
+    size[a] += size[b];
+  }
+};
+
+// Assigns the units of cnf and everything they imply by unit propagation.
+// value holds 1 or -1 for the variables fixed that way, 0 for the others,
+// and satisfied marks the clauses a fixed literal makes true. Returns false
+// on a conflict.
+static bool propagate_top_level(CNF *cnf, int num_vars, std::vector<signed char> &value,
+                                std::vector<char> &satisfied) {
+  size_t num_clauses = cnf->clauses.size();
+  std::vector<std::vector<uint32_t> > occurs(2 * num_vars);
+  std::vector<uint32_t> num_false(num_clauses, 0);
+  std::vector<lit> queue;
+
+  auto lit_value = [&value](lit L) {
+    return lit_is_pos(L) ? value[lit_var(L)] : -value[lit_var(L)];
+  };
+  auto assign = [&](lit L) {
+    value[lit_var(L)] = lit_is_pos(L) ? 1 : -1;
+    queue.push_back(L);
+  };
+
+  for (uint32_t c = 0; c < num_clauses; c++) {
+    std::vector<lit> &lits = cnf->clauses[c]->literals;
+    if (lits.empty()) return false;
+    for (auto L = lits.begin(); L != lits.end(); L++) occurs[*L].push_back(c);
+  }
+  for (uint32_t c = 0; c < num_clauses; c++) {
+    std::vector<lit> &lits = cnf->clauses[c]->literals;
+    if (lits.size() != 1) continue;
+    int v = lit_value(lits[0]);
+    if (v < 0) return false;
+    if (v == 0) assign(lits[0]);
+  }
+
+  for (size_t head = 0; head < queue.size(); head++) {
+    lit T = queue[head];
+    for (auto c = occurs[T].begin(); c != occurs[T].end(); c++) satisfied[*c] = 1;
+    for (auto c = occurs[lit_neg(T)].begin(); c != occurs[lit_neg(T)].end(); c++) {
+      std::vector<lit> &lits = cnf->clauses[*c]->literals;
+      if (satisfied[*c] || ++num_false[*c] + 1 < lits.size()) continue;
+      // at most one literal is left that is not false
+      lit open = 0;
+      bool has_open = false;
+      for (auto L = lits.begin(); L != lits.end(); L++) {
+        int v = lit_value(*L);
+        if (v > 0) {
+          has_open = false;
+          satisfied[*c] = 1;
+          break;
+        }
+        if (v == 0) {
+          open = *L;
+          has_open = true;
+        }
+      }
+      if (satisfied[*c]) continue;
+      if (!has_open) return false;
+      assign(open);
+    }
+  }
+  return true;
+}
+
+bool split_components(CNF *cnf, int num_vars, std::vector<cnf_component> &components,
+                      std::vector<lit> &fixed) {
+  std::vector<signed char> value(num_vars, 0);
+  std::vector<char> satisfied(cnf->clauses.size(), 0);
+  if (!propagate_top_level(cnf, num_vars, value, satisfied)) return false;
+  for (var v = 0; v < num_vars; v++) {
+    if (value[v]) fixed.push_back(mk_lit(v, value[v] > 0));
+  }
+
+  // what is left of every open clause: its literals on open variables
+  var_union_find uf(num_vars);
+  for (size_t c = 0; c < cnf->clauses.size(); c++) {
+    if (satisfied[c]) continue;
+    var first = -1;
+    std::vector<lit> &lits = cnf->clauses[c]->literals;
+    for (auto L = lits.begin(); L != lits.end(); L++) {
+      if (value[lit_var(*L)]) continue;
+      if (first < 0) first = lit_var(*L);
+      else uf.join(first, lit_var(*L));
+    }
+  }
+
+  std::vector<int> component_of_root(num_vars, -1);
+  std::vector<var> local_var(num_vars, -1);
+
+  for (size_t c = 0; c < cnf->clauses.size(); c++) {
+    if (satisfied[c]) continue;
+    std::vector<lit> &lits = cnf->clauses[c]->literals;
+    Clause *local = new Clause();
+    local->literals.reserve(lits.size());
+    cnf_component *comp = nullptr;
+    for (auto L = lits.begin(); L != lits.end(); L++) {
+      var v = lit_var(*L);
+      if (value[v]) continue;
+      if (!comp) {
+        var root = uf.find(v);
+        if (component_of_root[root] < 0) {
+          component_of_root[root] = components.size();
+          components.emplace_back();
+        }
+        comp = &components[component_of_root[root]];
+      }
+      if (local_var[v] < 0) {
+        local_var[v] = comp->vars.size();
+        comp->vars.push_back(v);
+      }
+      local->literals.push_back(mk_lit(local_var[v], lit_is_pos(*L)));
+    }
+    comp->cnf->clauses.push_back(local);
+  }
+
+  return true;
+}
+
+void free_components(std::vector<cnf_component> &components) {
+  for (auto comp = components.begin(); comp != components.end(); comp++) {
+    for (auto C = comp->cnf->clauses.begin(); C != comp->cnf->clauses.end(); C++) {
+      delete *C;
+    }
+    delete comp->cnf;
+  }
+  components.clear();
+}
+
+solve_result dpll_sat_components(CNF *cnf, int num_vars, int num_threads,
+                                 const dpll_options &opts, dpll_stats &stats,
+                                 assignment &result, std::ostream *trace) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<cnf_component> components;
+  std::vector<lit> fixed;
+  if (!split_components(cnf, num_vars, components, fixed)) {
+    if (trace) *trace << "Conflict among the units, nothing to solve" << std::endl;
+    return runsat;
+  }
+
+  size_t num_components = components.size();
+  if (trace) {
+    *trace << "Fixed " << fixed.size() << " variable(s) by unit propagation, split the rest into "
+           << num_components << " independent component(s)" << std::endl;
+  }
+
+  // hand out the biggest components first so one large straggler does not
+  // start last
+  std::vector<size_t> order(num_components);
+  for (size_t i = 0; i < num_components; i++) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&components](size_t a, size_t b) {
+    return components[a].cnf->clauses.size() > components[b].cnf->clauses.size();
+  });
+
+  std::vector<assignment> models(num_components);
+  std::vector<std::ostringstream> traces(trace ? num_components : 0);
+  std::vector<char> solved(num_components, 0);
+  std::vector<solve_result> results(num_components, runknown);
+  std::vector<dpll_stats> component_stats(num_components);
+  // an unsat component cancels the solves still running on other workers
+  std::vector<dpll_control> controls(num_components);
+  std::atomic<size_t> next(0);
+  std::atomic<bool> found_unsat(false);
+  std::atomic<bool> found_unknown(false);
+
+  auto worker = [&]() {
+    null_buffer nb;
+    std::ostream null_stream(&nb);
+
+    while (!found_unsat && !found_unknown) {
+      size_t k = next++;
+      if (k >= num_components) break;
+      size_t i = order[k];
+
+      // each component gets what is left of the time limit
+      dpll_options component_opts = opts;
+      // snapshots belong to a single solve
+      component_opts.checkpoint_path.clear();
+      component_opts.resume_path.clear();
+      if (opts.limits.max_seconds > 0) {
+        std::chrono::duration<double> used = std::chrono::steady_clock::now() - start;
+        double left = opts.limits.max_seconds - used.count();
+        if (left <= 0) {
+          component_stats[i].stopped_by = time_limit;
+          found_unknown = true;
+          break;
+        }
+        component_opts.limits.max_seconds = left;
+      }
+
+      std::ostream &out = trace ? static_cast<std::ostream &>(traces[i]) : null_stream;
+      results[i] = dpll_solve(components[i].cnf, components[i].vars.size(), component_opts,
+                              component_stats[i], models[i], out, &controls[i]);
+      if (results[i] == runsat) {
+        found_unsat = true;
+        for (auto c = controls.begin(); c != controls.end(); c++) c->cancel = true;
+      }
+      if (results[i] == runknown) found_unknown = true;
+      solved[i] = 1;
+    }
+  };
+
+  if (num_threads < 1) num_threads = 1;
+  if (static_cast<size_t>(num_threads) > num_components) num_threads = num_components;
+
+  if (num_threads <= 1) {
+    worker();
+  } else {
+    std::vector<std::thread> workers;
+    for (int t = 0; t < num_threads; t++) workers.emplace_back(worker);
+    for (auto it = workers.begin(); it != workers.end(); it++) it->join();
+  }
+
+  if (trace) {
+    for (size_t i = 0; i < num_components; i++) {
+      if (!solved[i]) continue;
+      *trace << "Component " << i << " (" << components[i].vars.size() << " variables, "
+             << components[i].cnf->clauses.size() << " clauses):" << std::endl
+             << traces[i].str();
+    }
+  }
+
+  for (size_t i = 0; i < num_components; i++) {
+    stats.decisions += component_stats[i].decisions;
+    stats.conflicts += component_stats[i].conflicts;
+    stats.pure_literals += component_stats[i].pure_literals;
+    const symmetry_stats &sym = component_stats[i].symmetry;
+    stats.symmetry.generators += sym.generators;
+    stats.symmetry.clauses += sym.clauses;
+    stats.symmetry.aux_vars += sym.aux_vars;
+    stats.symmetry.seconds += sym.seconds;
+    stats.symmetry.stopped_early = stats.symmetry.stopped_early || sym.stopped_early;
+    if (stats.stopped_by == no_limit) stats.stopped_by = component_stats[i].stopped_by;
+    if (component_stats[i].peak_memory_bytes > stats.peak_memory_bytes) {
+      stats.peak_memory_bytes = component_stats[i].peak_memory_bytes;
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  stats.seconds = elapsed.count();
+
+  // an unsat component decides the formula even if another one gave up
+  solve_result res = found_unsat ? runsat : found_unknown ? runknown : rsat;
+  if (res != runknown) stats.stopped_by = no_limit;
+  if (res == rsat) {
+    // unconstrained variables default to true, as in dpll_sat
+    result.assign(num_vars, true);
+    for (auto L = fixed.begin(); L != fixed.end(); L++) result[lit_var(*L)] = lit_is_pos(*L);
+    for (size_t i = 0; i < num_components; i++) {
+      std::vector<var> &vars = components[i].vars;
+      for (size_t j = 0; j < vars.size(); j++) result[vars[j]] = models[i][j];
+    }
+  }
+
+  free_components(components);
+  return res;
+}
@@ -0,0 +1,42 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <ostream>
+#include <vector>
+
+#include "cnf.h"
+#include "dpll.h"
+
+// A variable-disjoint piece of a CNF. Its clauses are renumbered to the
+// dense local variables 0..vars.size()-1; vars maps them back.
+struct cnf_component {
+  CNF *cnf;
+  std::vector<var> vars;
+
+  cnf_component() : cnf(new CNF()) {}
+};
+
+// Splits cnf into connected components of its variable-clause graph.
+// The units are propagated first and the variables they fix go to fixed
+// instead: the unit asserting the root of a Tseitin CNF would otherwise
+// tie every conjunct of the formula into one component. Clauses a fixed
+// literal satisfies are dropped and fixed false literals are removed.
+// Variables that occur in no clause belong to no component.
+// Returns false on a conflict among the units (no components are built then).
+bool split_components(CNF *cnf, int num_vars, std::vector<cnf_component> &components,
+                      std::vector<lit> &fixed);
+
+void free_components(std::vector<cnf_component> &components);
+
+// Solves every component with DPLL on up to num_threads worker threads and
+// stitches the component models into result. Unsat as soon as any
+// component is unsat, which also cancels the solves still running, unknown
+// if a component runs into a limit. The time
+// limit covers all components together, the other limits apply to each.
+// stats sums up the search effort of every component. Trace output is
+// written per component, in order, to trace if it is not null.
+solve_result dpll_sat_components(CNF *cnf, int num_vars, int num_threads,
+                                 const dpll_options &opts, dpll_stats &stats,
+                                 assignment &result, std::ostream *trace);
+
+#endif /* COMPONENTS_H */
@@ -0,0 +1,384 @@
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "count.h"
+
+// rough per-entry bookkeeping cost of the cache on top of key and count
+#define CACHE_ENTRY_OVERHEAD 96
+
+// A component is identified by its clause ids together with each clause's
+// unassigned literals; identical keys denote identical residual formulas.
+typedef std::vector<uint32_t> component_key;
+
+struct component_key_hash {
+  size_t operator()(const component_key &key) const {
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (auto it = key.begin(); it != key.end(); it++) {
+      h ^= *it;
+      h *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(h);
+  }
+};
+
+// component cache with least-recently-used eviction under a byte budget
+class component_cache {
+  struct entry {
+    bigcount count;
+    std::list<const component_key *>::iterator lru_pos;
+  };
+
+  std::unordered_map<component_key, entry, component_key_hash> entries;
+  std::list<const component_key *> lru; // most recently used first
+  size_t max_bytes;
+  size_t bytes;
+  count_stats &stats;
+
+  static size_t entry_bytes(const component_key &key, const bigcount &count) {
+    return key.size() * sizeof(uint32_t) + count.num_bytes() + CACHE_ENTRY_OVERHEAD;
+  }
+
+public:
+  component_cache(size_t max_b, count_stats &s) : max_bytes(max_b), bytes(0), stats(s) {}
+
+  bool lookup(const component_key &key, bigcount &count) {
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+      stats.cache_misses++;
+      return false;
+    }
+    stats.cache_hits++;
+    lru.splice(lru.begin(), lru, it->second.lru_pos);
+    count = it->second.count;
+    return true;
+  }
+
+  void store(const component_key &key, const bigcount &count) {
+    size_t size = entry_bytes(key, count);
+    if (size > max_bytes) return;
+
+    while (bytes + size > max_bytes && !lru.empty()) {
+      auto victim = entries.find(*lru.back());
+      bytes -= entry_bytes(victim->first, victim->second.count);
+      lru.pop_back();
+      entries.erase(victim);
+      stats.cache_evictions++;
+    }
+
+    auto res = entries.emplace(key, entry());
+    if (!res.second) return;
+    res.first->second.count = count;
+    lru.push_front(&res.first->first);
+    res.first->second.lru_pos = lru.begin();
+    bytes += size;
+    if (bytes > stats.cache_peak_bytes) stats.cache_peak_bytes = bytes;
+  }
+};
+
+class model_counter {
+  int num_vars;
+  // variables below this are branched on and counted
+  int num_proj;
+
+  std::vector<lit> lits;
+  std::vector<size_t> clause_start;     // clause c is lits[clause_start[c] .. clause_start[c+1])
+  std::vector<std::vector<int> > occ;   // literal -> clauses containing it
+
+  std::vector<int8_t> value;            // per variable: -1 unassigned, 0 false, 1 true
+  std::vector<var> trail;
+  size_t qhead;
+
+  // scratch space, reset lazily through epochs
+  std::vector<unsigned> var_epoch;
+  std::vector<int> var_scratch;
+  unsigned epoch;
+  std::vector<var> uf_parent;
+  std::vector<unsigned> uf_epoch;
+  unsigned uf_round;
+
+  component_cache cache;
+  count_stats &stats;
+
+  enum clause_state {cl_sat, cl_conflict, cl_unit, cl_open};
+
+  int lit_value(lit L) const {
+    int8_t v = value[lit_var(L)];
+    if (v < 0) return -1;
+    return v == (lit_is_pos(L) ? 1 : 0);
+  }
+
+  clause_state check_clause(int c, lit *unit) const {
+    int num_undef = 0;
+    for (size_t i = clause_start[c]; i < clause_start[c + 1]; i++) {
+      int v = lit_value(lits[i]);
+      if (v == 1) return cl_sat;
+      if (v < 0) {
+        num_undef++;
+        *unit = lits[i];
+      }
+    }
+    if (num_undef == 0) return cl_conflict;
+    if (num_undef == 1) return cl_unit;
+    return cl_open;
+  }
+
+  void assign(lit L) {
+    value[lit_var(L)] = lit_is_pos(L) ? 1 : 0;
+    trail.push_back(lit_var(L));
+  }
+
+  void undo(size_t mark) {
+    while (trail.size() > mark) {
+      value[trail.back()] = -1;
+      trail.pop_back();
+    }
+    qhead = std::min(qhead, mark);
+  }
+
+  // unit propagation from the unprocessed part of the trail
+  bool propagate() {
+    while (qhead < trail.size()) {
+      var v = trail[qhead++];
+      lit now_false = mk_lit(v, value[v] == 0);
+      const std::vector<int> &cs = occ[now_false];
+      for (auto it = cs.begin(); it != cs.end(); it++) {
+        lit unit;
+        switch (check_clause(*it, &unit)) {
+          case cl_conflict:
+            qhead = trail.size();
+            return false;
+          case cl_unit:
+            assign(unit);
+            break;
+          default:
+            break;
+        }
+      }
+    }
+    return true;
+  }
+
+  var uf_find(var v) {
+    if (uf_epoch[v] != uf_round) {
+      uf_epoch[v] = uf_round;
+      uf_parent[v] = v;
+    }
+    while (uf_parent[v] != v) {
+      uf_parent[v] = uf_parent[uf_parent[v]];
+      v = uf_parent[v];
+    }
+    return v;
+  }
+
+  // group the given open clauses into components over their unassigned variables
+  void split(const std::vector<int> &clauses, std::vector<std::vector<int> > &components) {
+    uf_round++;
+    for (auto c = clauses.begin(); c != clauses.end(); c++) {
+      var first = -1;
+      for (size_t i = clause_start[*c]; i < clause_start[*c + 1]; i++) {
+        if (value[lit_var(lits[i])] >= 0) continue;
+        var v = uf_find(lit_var(lits[i]));
+        if (first < 0) {
+          first = v;
+        } else if (v != first) {
+          uf_parent[v] = first;
+        }
+      }
+    }
+
+    // component index of each root, kept in var_scratch
+    epoch++;
+    for (auto c = clauses.begin(); c != clauses.end(); c++) {
+      var root = -1;
+      for (size_t i = clause_start[*c]; i < clause_start[*c + 1] && root < 0; i++) {
+        if (value[lit_var(lits[i])] < 0) root = uf_find(lit_var(lits[i]));
+      }
+      if (var_epoch[root] != epoch) {
+        var_epoch[root] = epoch;
+        var_scratch[root] = components.size();
+        components.emplace_back();
+      }
+      components[var_scratch[root]].push_back(*c);
+    }
+  }
+
+  // plain DPLL on a component without projection variables; leaves the
+  // assignment as it found it
+  bool satisfiable(const std::vector<int> &clauses) {
+    for (auto c = clauses.begin(); c != clauses.end(); c++) {
+      lit unit;
+      if (check_clause(*c, &unit) == cl_sat) continue;
+
+      for (size_t i = clause_start[*c]; i < clause_start[*c + 1]; i++) {
+        if (value[lit_var(lits[i])] >= 0) continue;
+
+        lit branches[2] = {lits[i], lit_neg(lits[i])};
+        for (int b = 0; b < 2; b++) {
+          size_t mark = trail.size();
+          assign(branches[b]);
+          bool ok = propagate() && satisfiable(clauses);
+          undo(mark);
+          if (ok) return true;
+        }
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // count of the open clauses among clauses, times 2 for every projection
+  // variable of vars that no longer occurs in them
+  bigcount count_residual(const std::vector<int> &clauses, const std::vector<var> &vars) {
+    std::vector<int> open;
+    epoch++;
+    for (auto c = clauses.begin(); c != clauses.end(); c++) {
+      lit unit;
+      if (check_clause(*c, &unit) == cl_sat) continue;
+      open.push_back(*c);
+      for (size_t i = clause_start[*c]; i < clause_start[*c + 1]; i++) {
+        var_epoch[lit_var(lits[i])] = epoch;
+      }
+    }
+
+    size_t num_free = 0;
+    for (auto v = vars.begin(); v != vars.end(); v++) {
+      if (*v < num_proj && value[*v] < 0 && var_epoch[*v] != epoch) num_free++;
+    }
+
+    std::vector<std::vector<int> > components;
+    split(open, components);
+
+    bigcount result(1);
+    for (auto comp = components.begin(); comp != components.end(); comp++) {
+      result *= count_component(*comp);
+      if (result.is_zero()) return result;
+    }
+    result.shift_left(num_free);
+    return result;
+  }
+
+  bigcount count_component(const std::vector<int> &clauses) {
+    stats.components++;
+
+    // build the cache key and collect the unassigned variables, counting
+    // occurrences of each to pick the branching variable
+    component_key key;
+    std::vector<var> vars;
+    epoch++;
+    for (auto c = clauses.begin(); c != clauses.end(); c++) {
+      key.push_back(*c);
+      for (size_t i = clause_start[*c]; i < clause_start[*c + 1]; i++) {
+        var v = lit_var(lits[i]);
+        if (value[v] >= 0) continue;
+        key.push_back(lits[i]);
+        if (var_epoch[v] != epoch) {
+          var_epoch[v] = epoch;
+          var_scratch[v] = 0;
+          vars.push_back(v);
+        }
+        var_scratch[v]++;
+      }
+      key.push_back(UINT32_MAX);
+    }
+
+    bigcount result;
+    if (cache.lookup(key, result)) return result;
+
+    var branch_var = -1;
+    for (auto v = vars.begin(); v != vars.end(); v++) {
+      if (*v >= num_proj) continue;
+      if (branch_var < 0 || var_scratch[*v] > var_scratch[branch_var]) branch_var = *v;
+    }
+
+    if (branch_var < 0) {
+      // only existentially quantified variables left
+      result = bigcount(satisfiable(clauses) ? 1 : 0);
+    } else {
+      for (int b = 0; b < 2; b++) {
+        stats.decisions++;
+        size_t mark = trail.size();
+        assign(mk_lit(branch_var, b == 0));
+        if (propagate()) result += count_residual(clauses, vars);
+        undo(mark);
+      }
+    }
+
+    cache.store(key, result);
+    return result;
+  }
+
+public:
+  model_counter(CNF *cnf, int n, int n_proj, const count_options &opts, count_stats &s) :
+    num_vars(n), num_proj(n_proj), occ(2 * n), value(n, -1), qhead(0),
+    var_epoch(n, 0), var_scratch(n, 0), epoch(0),
+    uf_parent(n, 0), uf_epoch(n, 0), uf_round(0),
+    cache(opts.cache_bytes, s), stats(s) {
+    if (opts.aux_defined) num_proj = num_vars;
+    clause_start.push_back(0);
+
+    std::vector<lit> C;
+    for (auto it = cnf->clauses.begin(); it != cnf->clauses.end(); it++) {
+      // drop repeated literals and tautologies
+      C = (*it)->literals;
+      std::sort(C.begin(), C.end());
+      C.erase(std::unique(C.begin(), C.end()), C.end());
+
+      bool tautology = false;
+      for (size_t i = 1; i < C.size(); i++) {
+        if (C[i] == lit_neg(C[i - 1])) tautology = true;
+      }
+      if (tautology) continue;
+
+      int c = clause_start.size() - 1;
+      for (auto L = C.begin(); L != C.end(); L++) {
+        lits.push_back(*L);
+        occ[*L].push_back(c);
+      }
+      clause_start.push_back(lits.size());
+    }
+  }
+
+  bigcount count() {
+    int num_clauses = clause_start.size() - 1;
+    std::vector<int> clauses(num_clauses);
+    for (int c = 0; c < num_clauses; c++) clauses[c] = c;
+
+    // top-level unit propagation
+    for (int c = 0; c < num_clauses; c++) {
+      lit unit;
+      switch (check_clause(c, &unit)) {
+        case cl_conflict:
+          return bigcount(0);
+        case cl_unit:
+          assign(unit);
+          if (!propagate()) return bigcount(0);
+          break;
+        default:
+          break;
+      }
+    }
+
+    std::vector<var> proj_vars(num_proj);
+    for (int v = 0; v < num_proj; v++) proj_vars[v] = v;
+    return count_residual(clauses, proj_vars);
+  }
+};
+
+bigcount count_models(CNF *cnf, int num_vars, int num_projection_vars,
+                      const count_options &opts, count_stats &stats,
+                      std::ostream &output_pref) {
+  output_pref << "Counting models over " << num_projection_vars << " of "
+              << num_vars << " variables" << std::endl;
+
+  model_counter counter(cnf, num_vars, num_projection_vars, opts, stats);
+  bigcount result = counter.count();
+
+  output_pref << stats.decisions << " decisions, " << stats.components << " components, "
+              << stats.cache_hits << " cache hits, " << stats.cache_misses << " misses, "
+              << stats.cache_evictions << " evictions, peak cache "
+              << stats.cache_peak_bytes << " bytes" << std::endl;
+  return result;
+}
@@ -0,0 +1,45 @@
+#ifndef COUNT_H
+#define COUNT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "bigcount.h"
+#include "cnf.h"
+
+struct count_options {
+  // memory bound for the component cache, least recently used entries go first
+  size_t cache_bytes;
+  // the variables outside the projection are functionally defined by the
+  // projection variables, as Tseitin auxiliaries are. Counting may then
+  // branch on them, which lets components split along gate outputs.
+  bool aux_defined;
+
+  count_options() : cache_bytes(256 << 20), aux_defined(false) {}
+};
+
+struct count_stats {
+  uint64_t decisions;
+  uint64_t components;
+  uint64_t cache_hits;
+  uint64_t cache_misses;
+  uint64_t cache_evictions;
+  size_t cache_peak_bytes;
+
+  count_stats() :
+    decisions(0), components(0), cache_hits(0), cache_misses(0),
+    cache_evictions(0), cache_peak_bytes(0) {}
+};
+
+// Exact model count of cnf projected onto variables 0..num_projection_vars-1
+// (the primitive variables of the input formula). Every other variable is
+// existentially quantified, so Tseitin auxiliaries do not multiply the count.
+// With aux_defined, each model over the projection extends to exactly one
+// full model, so the full count is taken instead.
+// Uses dynamic component decomposition with a bounded component cache.
+bigcount count_models(CNF *cnf, int num_vars, int num_projection_vars,
+                      const count_options &opts, count_stats &stats,
+                      std::ostream &output_pref);
+
+#endif /* COUNT_H */
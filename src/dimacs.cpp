@@ -0,0 +1,79 @@
+#include <cinttypes>
+
+#include "dimacs.h"
+
+// size of the output buffer
+#define DIMACS_BUFFER_BYTES (1 << 20)
+
+// digits reserved for each count in the header
+#define DIMACS_HEADER_DIGITS 20
+
+dimacs_writer::dimacs_writer() : file(nullptr), header_pos(0), num_clauses(0), failed(false) {
+  buf.reserve(DIMACS_BUFFER_BYTES);
+}
+
+dimacs_writer::~dimacs_writer() {
+  if (file) std::fclose(file);
+}
+
+void dimacs_writer::flush() {
+  if (!buf.empty() && std::fwrite(buf.data(), 1, buf.size(), file) != buf.size()) failed = true;
+  buf.clear();
+}
+
+void dimacs_writer::put_int(int64_t x) {
+  char digits[24];
+  int n = 0;
+  bool negative = x < 0;
+  uint64_t u = negative ? -static_cast<uint64_t>(x) : x;
+  do {
+    digits[n++] = '0' + u % 10;
+    u /= 10;
+  } while (u);
+  if (negative) put('-');
+  while (n) put(digits[--n]);
+}
+
+bool dimacs_writer::open(const std::string &path, const rmap_t *Rmap, int num_primitive_vars) {
+  file = std::fopen(path.c_str(), "wb");
+  if (!file) return false;
+
+  for (int v = 0; v < num_primitive_vars; v++) {
+    put('c');
+    put(' ');
+    put_int(v + 1);
+    put(' ');
+    const std::string &name = (*Rmap)[v];
+    for (auto it = name.begin(); it != name.end(); it++) put(*it);
+    put('\n');
+  }
+  flush();
+
+  // the placeholder is overwritten with a line of the same length
+  header_pos = std::ftell(file);
+  std::fprintf(file, "p cnf %*d %*d\n", DIMACS_HEADER_DIGITS, 0, DIMACS_HEADER_DIGITS, 0);
+  return header_pos >= 0 && !std::ferror(file);
+}
+
+void dimacs_writer::add_clause(Clause *C) {
+  for (auto L = C->literals.begin(); L != C->literals.end(); L++) {
+    int64_t v = lit_var(*L) + 1;
+    put_int(lit_is_pos(*L) ? v : -v);
+    put(' ');
+  }
+  put('0');
+  put('\n');
+  num_clauses++;
+  delete C;
+}
+
+bool dimacs_writer::finish(int num_vars) {
+  flush();
+  if (std::fseek(file, header_pos, SEEK_SET) != 0) failed = true;
+  std::fprintf(file, "p cnf %*d %*" PRIu64 "\n", DIMACS_HEADER_DIGITS, num_vars,
+               DIMACS_HEADER_DIGITS, num_clauses);
+  bool ok = !failed && !std::ferror(file);
+  ok = std::fclose(file) == 0 && ok;
+  file = nullptr;
+  return ok;
+}
@@ -0,0 +1,50 @@
+#ifndef DIMACS_H
+#define DIMACS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "cnf.h"
+#include "parser.h"
+
+// Writes a CNF in DIMACS format as its clauses arrive, without keeping
+// them. The file starts with a "c <var> <name>" comment per primitive
+// variable and a header with room for the counts, which is filled in by
+// finish once they are known, so the file has to be seekable. Variable v
+// is written as v + 1.
+class dimacs_writer : public clause_sink {
+  FILE *file;
+  std::vector<char> buf;
+  long header_pos;
+  uint64_t num_clauses;
+  bool failed;
+
+  void flush();
+  void put(char c) {
+    if (buf.size() == buf.capacity()) flush();
+    buf.push_back(c);
+  }
+  void put_int(int64_t x);
+
+public:
+  dimacs_writer();
+  ~dimacs_writer();
+
+  // creates path and writes the comments and the header placeholder
+  bool open(const std::string &path, const rmap_t *Rmap, int num_primitive_vars);
+
+  // writes C and deletes it
+  virtual void add_clause(Clause *C);
+
+  // writes the counts into the header and closes the file, false if any
+  // write failed
+  bool finish(int num_vars);
+
+  uint64_t clauses_written() const {
+    return num_clauses;
+  }
+};
+
+#endif /* DIMACS_H */
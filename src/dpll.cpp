@@ -1,67 +1,23 @@
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cstdio>
+#include <chrono>
+#include <future>
 #include <vector>
 #include <set>
 #include <iostream>
+#include <functional>
 
 #include "dpll.h"
+#include "interp.h"
 #include "parser.h"
+#include "xor.h"
+#include "implication.h"
+#include "bitset.h"
+#include "checkpoint.h"
 
-std::ostream *output;
-
-// variable interpretation
-enum vinterp {vtrue, vfalse, vundef};
-
-void print_vinterp(vinterp vi) {
-  switch (vi) {
-    case vtrue:
-      std::cout << "vtrue";
-      break;
-    case vfalse:
-      std::cout << "vfalse";
-      break;
-    case vundef:
-      std::cout << "vundef";
-      break;
-  }
-}
-
-// A full interpretation (maps variable to a variable interp)
-struct Interp {
-  std::vector<vinterp> asmts;
-
-  Interp(size_t size) {
-    asmts.reserve(size);
-    for (size_t i = 0; i < size; i++) {
-      asmts.push_back(vundef);
-    }
-  }
-
-  vinterp satisfies(Literal *L) {
-    switch (asmts[L->v]) {
-      case vtrue:
-        return L->is_true ? vtrue : vfalse;
-      case vfalse:
-        return L->is_true ? vfalse : vtrue;
-      case vundef:
-        return vundef;
-    }
-  }
-
-  void update(int var, vinterp vi) {
-    asmts[var] = vi;
-  }
-  void update(int var, bool vi) {
-    asmts[var] = vi ? vtrue : vfalse;
-  }
-
-  void quick_print() {
-    std::cout << "[" << asmts.size() << "] ";
-    for (int i = 0; i < asmts.size(); i++) {
-      print_vinterp(asmts[i]);
-      std::cout << " ";
-    }
-    std::cout << std::endl;
-  }
-};
+// largest XOR (in variables) recovered from clauses, it takes 2^(k-1) of them
+#define XOR_MAX_RECOVER_SIZE 5
 
 // clause interpretation
 enum cinterp {ctrue, cfalse, cunit, cundef};
@@ -93,6 +49,14 @@ struct dpll_decision {
     props.emplace(prop_var, prop_asmt);
   }
 
+  // undo every propagation made under this decision
+  void revert_propagations(Interp *I) {
+    for (auto it = props.begin(); it != props.end(); it++) {
+      I->update(it->prop_var, vundef);
+    }
+    props.clear();
+  }
+
   void flip_decision() {
     decision_asmt = !decision_asmt;
     has_been_flipped = true;
@@ -132,6 +96,14 @@ class dpll_logger {
     output << *C << " ";
   }
 
+  void write_binary(lit a, lit b) {
+    output << "(";
+    print_lit(output, a);
+    output << "|";
+    print_lit(output, b);
+    output << ") ";
+  }
+
 public:
   dpll_logger(std::ostream &o) : prefix(""), output(o) {}
 
@@ -159,6 +131,43 @@ public:
     output << std::endl;
   }
 
+  // reason implied the value through the clause (!reason | the literal)
+  void log_binary_propagation(int var, bool var_asmt, lit reason) {
+    write_prefix();
+    output << "Propagate ";
+    write_assignment(var, var_asmt);
+    write_binary(lit_neg(reason), mk_lit(var, var_asmt));
+    output << std::endl;
+  }
+
+  void log_binary_conflict(lit reason, lit falsified) {
+    write_prefix();
+    output << "Backtrack ";
+    write_binary(lit_neg(reason), falsified);
+    output << std::endl;
+    dedent();
+  }
+
+  void log_xor_propagation(int var, bool var_asmt) {
+    write_prefix();
+    output << "Propagate ";
+    write_assignment(var, var_asmt);
+    output << "(xor)" << std::endl;
+  }
+
+  void log_pure(int var, bool var_asmt) {
+    write_prefix();
+    output << "Pure ";
+    write_assignment(var, var_asmt);
+    output << std::endl;
+  }
+
+  void log_xor_conflict() {
+    write_prefix();
+    output << "Backtrack (xor)" << std::endl;
+    dedent();
+  }
+
   void log_backtrack(Clause *C) {
     write_prefix();
     output << "Backtrack ";
@@ -168,21 +177,119 @@ public:
   }
 };
 
-dpll_logger *Logger;
+// Counts, per literal, the clauses containing it that no true literal
+// satisfies yet. A variable with a zero count for one literal and a
+// nonzero count for the other is pure: the other literal can be made true
+// without falsifying any open clause. The counts follow every assignment
+// and unassignment as an observer of the interpretation, and a variable
+// is queued as a candidate whenever one of its counts reaches or leaves
+// zero, so pure variables are found without rescanning. Binary clauses
+// without a clause object are numbered after the clauses of cnf.
+class pure_literal_counter : public interp_observer {
+  CNF *cnf;
+  std::vector<lit> binary_lits;           // two per binary clause
+  std::vector<std::vector<int> > occurs;  // literal -> clauses containing it
+  std::vector<int> num_true;              // clause -> true literals
+  std::vector<int> num_open;              // literal -> open clauses containing it
+  std::vector<var> candidates;
+  std::vector<bool> excluded;
+
+  const lit *clause_begin(size_t c) const {
+    if (c < cnf->clauses.size()) return cnf->clauses[c]->literals.data();
+    return &binary_lits[2 * (c - cnf->clauses.size())];
+  }
+  const lit *clause_end(size_t c) const {
+    if (c < cnf->clauses.size()) return clause_begin(c) + cnf->clauses[c]->literals.size();
+    return clause_begin(c) + 2;
+  }
+
+  void make_true(lit T) {
+    for (auto c = occurs[T].begin(); c != occurs[T].end(); c++) {
+      if (num_true[*c]++ != 0) continue;
+      for (const lit *L = clause_begin(*c); L != clause_end(*c); L++) {
+        if (--num_open[*L] == 0) candidates.push_back(lit_var(*L));
+      }
+    }
+  }
+
+  void make_untrue(lit T) {
+    for (auto c = occurs[T].begin(); c != occurs[T].end(); c++) {
+      if (--num_true[*c] != 0) continue;
+      for (const lit *L = clause_begin(*c); L != clause_end(*c); L++) {
+        if (num_open[*L]++ == 0) candidates.push_back(lit_var(*L));
+      }
+    }
+  }
+
+public:
+  // variables of xe take part in XORs the counts do not see, they are
+  // never pure
+  pure_literal_counter(CNF *c, const std::vector<std::pair<lit, lit> > &binaries, int num_vars,
+                       xor_engine *xe) :
+    cnf(c), occurs(2 * num_vars), num_true(c->clauses.size() + binaries.size(), 0),
+    num_open(2 * num_vars, 0), excluded(num_vars, false) {
+    for (auto b = binaries.begin(); b != binaries.end(); b++) {
+      binary_lits.push_back(b->first);
+      binary_lits.push_back(b->second);
+    }
+    for (size_t i = 0; i < num_true.size(); i++) {
+      for (const lit *L = clause_begin(i); L != clause_end(i); L++) {
+        occurs[*L].push_back(i);
+        num_open[*L]++;
+      }
+    }
+    for (var v = 0; v < num_vars; v++) {
+      if (xe && xe->has_var(v)) excluded[v] = true;
+      candidates.push_back(v);
+    }
+  }
+
+  void on_update(int var, vinterp from, vinterp to) {
+    if (from != vundef) make_untrue(mk_lit(var, from == vtrue));
+    if (to != vundef) make_true(mk_lit(var, to == vtrue));
+    // its own clauses reopen, it may be pure again
+    else candidates.push_back(var);
+  }
+
+  // the true literal of an unassigned pure variable, if there is one
+  bool next_pure(const Interp *I, lit *L) {
+    while (!candidates.empty()) {
+      var v = candidates.back();
+      candidates.pop_back();
+      if (excluded[v] || I->value(v) != vundef) continue;
+
+      int pos = num_open[mk_lit(v, true)];
+      int neg = num_open[mk_lit(v, false)];
+      if ((pos == 0) == (neg == 0)) continue;
+      *L = mk_lit(v, pos > 0);
+      return true;
+    }
+    return false;
+  }
+};
 
 // determine the interpretation of a disjunctive clause
 cinterp interpret_clause(Clause *C, Interp *I, int *undef_var, bool *undef_sat_interp) {
   bool seen_undef = false;
+  lit undef_lit = 0;
   for (auto it = C->literals.begin(); it != C->literals.end(); it++) {
     switch (I->satisfies(*it)) {
       case vtrue:
         return ctrue;
       case vundef:
-        if (seen_undef) return cundef;
+        if (seen_undef) {
+          // a repeated literal does not make the clause any less unit
+          if (undef_lit == *it) break;
+          return cundef;
+        }
 
         seen_undef = true;
-        if (undef_var) *undef_var = (*it)->v;
-        if (undef_sat_interp) *undef_sat_interp = (*it)->is_true ? true : false;
+        undef_lit = *it;
+        if (undef_var) *undef_var = lit_var(*it);
+        if (undef_sat_interp) *undef_sat_interp = lit_is_pos(*it);
+        break;
+      default:
+        break;
     }
   }
 
@@ -208,36 +315,80 @@ vinterp interpret_cnf(CNF *cnf, Interp *I, Clause **offending_clause) {
   return vtrue;
 }
 
-Clause *find_unit_clause(CNF *cnf, Interp *I, int *unit_var, bool *unit_interp) {
+// also stops at a falsified clause, which the binary implications can
+// leave behind without making it unit first
+Clause *find_unit_clause(CNF *cnf, Interp *I, int *unit_var, bool *unit_interp,
+                         bool *falsified) {
+  *falsified = false;
   for (auto C = cnf->clauses.begin(); C != cnf->clauses.end(); C++) {
-    if (interpret_clause(*C, I, unit_var, unit_interp) == cunit) {
-      return *C;
+    switch (interpret_clause(*C, I, unit_var, unit_interp)) {
+      case cunit:
+        return *C;
+      case cfalse:
+        *falsified = true;
+        return *C;
+      default:
+        break;
     }
   }
   return nullptr;
 }
 
+// makes everything T implies through the binary clauses true, breadth
+// first. returns false on a conflict.
+bool propagate_binary(implication_graph *bins, lit T, Interp *I, dpll_decision &dec,
+                      dpll_logger *Logger) {
+  std::vector<lit> queue(1, T);
+  for (size_t head = 0; head < queue.size(); head++) {
+    lit reason = queue[head];
+    for (const lit *L = bins->begin(reason); L != bins->end(reason); L++) {
+      switch (I->satisfies(*L)) {
+        case vtrue:
+          break;
+        case vfalse:
+          Logger->log_binary_conflict(reason, *L);
+          return false;
+        case vundef:
+          Logger->log_binary_propagation(lit_var(*L), lit_is_pos(*L), reason);
+          I->update(lit_var(*L), lit_is_pos(*L));
+          dec.add_propagation(lit_var(*L), lit_is_pos(*L));
+          queue.push_back(*L);
+          break;
+      }
+    }
+  }
+  return true;
+}
+
 // attempts to unit propagate until it cannot
 // returns true if completed without problems (result could be sat or undef)
 // returns false if resulting function is non-sat and it backtracked
-bool unit_propagate_all(CNF *cnf, Interp *I, dpll_decision &dec) {
+bool unit_propagate_all(CNF *cnf, Interp *I, dpll_decision &dec, implication_graph *bins,
+                        dpll_logger *Logger) {
   int unit_var;
   bool unit_interp;
   bool has_conflict = false;
+  bool falsified;
   Clause *target_clause;
   
-  target_clause = find_unit_clause(cnf, I, &unit_var, &unit_interp);
+  target_clause = find_unit_clause(cnf, I, &unit_var, &unit_interp, &falsified);
   if (!target_clause) {
     // failed to find unit, implies no conflicts
     return true;
   }
+  if (falsified) {
+    Logger->log_backtrack(target_clause);
+    return false;
+  }
 
   Logger->log_propagation(unit_var, unit_interp, target_clause);
   I->update(unit_var, unit_interp);
-  if (interpret_cnf(cnf, I, &target_clause) == vfalse) {
+  if (bins && !propagate_binary(bins, mk_lit(unit_var, unit_interp), I, dec, Logger)) {
+    has_conflict = true;
+  } else if (interpret_cnf(cnf, I, &target_clause) == vfalse) {
     Logger->log_backtrack(target_clause);
     has_conflict = true;
-  } else if (!unit_propagate_all(cnf, I, dec)) {
+  } else if (!unit_propagate_all(cnf, I, dec, bins, Logger)) {
     has_conflict = true;
   }
 
@@ -253,6 +404,51 @@ bool unit_propagate_all(CNF *cnf, Interp *I, dpll_decision &dec) {
   return true;
 }
 
+// alternates clause and XOR propagation until neither finds anything new,
+// starting from the binary implications of the decision
+// same return convention as unit_propagate_all
+bool propagate_all(CNF *cnf, Interp *I, dpll_decision &dec, xor_engine *xe,
+                   implication_graph *bins, dpll_logger *Logger) {
+  std::vector<lit> implied;
+
+  if (bins && dec.decision_var >= 0 &&
+      !propagate_binary(bins, mk_lit(dec.decision_var, dec.decision_asmt), I, dec, Logger)) {
+    return false;
+  }
+
+  while (true) {
+    if (!unit_propagate_all(cnf, I, dec, bins, Logger)) return false;
+    if (!xe) return true;
+
+    implied.clear();
+    if (!xe->propagate(I, implied)) {
+      Logger->log_xor_conflict();
+      return false;
+    }
+    if (implied.empty()) return true;
+
+    for (auto L = implied.begin(); L != implied.end(); L++) {
+      // an earlier implication may have set it through a binary clause
+      if (I->satisfies(*L) == vtrue) continue;
+      if (I->satisfies(*L) == vfalse) {
+        Logger->log_xor_conflict();
+        return false;
+      }
+      Logger->log_xor_propagation(lit_var(*L), lit_is_pos(*L));
+      I->update(lit_var(*L), lit_is_pos(*L));
+      dec.add_propagation(lit_var(*L), lit_is_pos(*L));
+      if (bins && !propagate_binary(bins, *L, I, dec, Logger)) return false;
+    }
+
+    // several implications at once can falsify a clause without making it unit first
+    Clause *offending_clause;
+    if (interpret_cnf(cnf, I, &offending_clause) == vfalse) {
+      Logger->log_backtrack(offending_clause);
+      return false;
+    }
+  }
+}
+
 // returns true if decided a variable
 // returns false if no undef clause exists
 bool decide(CNF *cnf, Interp *I, int *undef_var, bool *undef_sat_interp) {
@@ -267,11 +463,12 @@ bool decide(CNF *cnf, Interp *I, int *undef_var, bool *undef_sat_interp) {
 
 // convert from a satisfying interpretation to assignment
 void sat_interp_to_assignment(Interp *I, assignment &asmt) {
-  int num_vars = I->asmts.size();
+  int num_vars = I->num_vars();
+  asmt.clear();
   asmt.reserve(num_vars);
 
   for (int i = 0; i < num_vars; i++) {
-    switch (I->asmts[i]) {
+    switch (I->value(i)) {
       case vtrue:
         asmt.push_back(true);
         break;
@@ -285,75 +482,492 @@ void sat_interp_to_assignment(Interp *I, assignment &asmt) {
   }
 }
 
-bool dpll_main(CNF *cnf, Interp *I) {
+// undo the search up to the last decision that has not yet been flipped
+// and flip it. returns false if every decision has been flipped already.
+bool backtrack(std::vector<dpll_decision> &decisions, Interp *I, xor_engine *xe,
+               dpll_logger *Logger) {
+  while (decisions.size() > 1) {
+    dpll_decision &last_decision = decisions.back();
+    last_decision.revert_propagations(I);
+    // back to the matrix from before this decision
+    if (xe) xe->pop_level();
+    if (!last_decision.has_been_flipped) {
+      if (xe) xe->push_level();
+      last_decision.flip_decision();
+      I->update(last_decision.decision_var, last_decision.decision_asmt);
+      Logger->log_redecision(decisions.back());
+      return true;
+    } else {
+      Logger->log_backtrack(nullptr);
+      I->update(last_decision.decision_var, vundef);
+      decisions.pop_back();
+    }
+  }
+
+  return false;
+}
+
+const char *limit_name(limit_kind kind) {
+  switch (kind) {
+    case no_limit:
+      return "none";
+    case time_limit:
+      return "time limit";
+    case decision_limit:
+      return "decision limit";
+    case conflict_limit:
+      return "conflict limit";
+    case memory_limit:
+      return "memory limit";
+    case cancelled:
+      return "cancel request";
+  }
+  return "";
+}
+
+size_t current_memory_bytes() {
+  // the second field of statm is the resident set in pages
+  FILE *statm = std::fopen("/proc/self/statm", "r");
+  if (!statm) return peak_memory_bytes();
+  unsigned long size, resident;
+  int fields = std::fscanf(statm, "%lu %lu", &size, &resident);
+  std::fclose(statm);
+  if (fields != 2) return peak_memory_bytes();
+  return static_cast<size_t>(resident) * sysconf(_SC_PAGESIZE);
+}
+
+size_t peak_memory_bytes() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+  return usage.ru_maxrss;
+#else
+  // kilobytes on linux
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+// where and when dpll_main saves its state, and the state to start from
+struct dpll_checkpointer {
+  std::string path;
+  double interval;
+  double next;
+  uint64_t cnf_hash;
+  int num_vars;
+  // nullptr to start from scratch
+  const dpll_snapshot *resume;
+
+  void save(const std::vector<dpll_decision> &decisions, dpll_stats &stats) {
+    dpll_snapshot snapshot;
+    snapshot.cnf_hash = cnf_hash;
+    snapshot.num_vars = num_vars;
+    snapshot.decisions = stats.decisions;
+    snapshot.conflicts = stats.conflicts;
+    snapshot.pure_literals = stats.pure_literals;
+    snapshot.levels.resize(decisions.size());
+    for (size_t i = 0; i < decisions.size(); i++) {
+      const dpll_decision &d = decisions[i];
+      dpll_snapshot::level &l = snapshot.levels[i];
+      l.var = d.decision_var;
+      l.asmt = d.decision_asmt;
+      l.flipped = d.has_been_flipped;
+      l.props.reserve(d.props.size());
+      for (auto p = d.props.begin(); p != d.props.end(); p++) {
+        l.props.push_back(mk_lit(p->prop_var, p->prop_asmt));
+      }
+    }
+    if (write_snapshot(path, snapshot)) stats.checkpoints++;
+    else stats.checkpoint_failures++;
+  }
+
+  // redoes the assignments of the snapshot level by level, folding each
+  // level into the XOR matrix before the next decision as the search did
+  void replay(std::vector<dpll_decision> &decisions, Interp *I, xor_engine *xe,
+              dpll_stats &stats) {
+    std::vector<lit> implied;
+    for (size_t i = 0; i < resume->levels.size(); i++) {
+      const dpll_snapshot::level &l = resume->levels[i];
+      if (i > 0) {
+        if (xe) xe->push_level();
+        I->update(l.var, l.asmt);
+      }
+      decisions.emplace_back(l.var, l.asmt);
+      decisions.back().has_been_flipped = l.flipped;
+      for (auto L = l.props.begin(); L != l.props.end(); L++) {
+        I->update(lit_var(*L), lit_is_pos(*L));
+        decisions.back().add_propagation(lit_var(*L), lit_is_pos(*L));
+      }
+      if (xe && i + 1 < resume->levels.size()) {
+        implied.clear();
+        xe->propagate(I, implied);
+      }
+    }
+    stats.decisions = resume->decisions;
+    stats.conflicts = resume->conflicts;
+    stats.pure_literals = resume->pure_literals;
+    stats.resumed = true;
+  }
+};
+
+solve_result dpll_main(CNF *cnf, Interp *I, xor_engine *xe, implication_graph *bins,
+                       pure_literal_counter *pure, dpll_budget &budget,
+                       dpll_checkpointer *checkpoint, dpll_logger *Logger) {
   int undef_var;
   bool undef_sat_interp;
   bool can_decide, can_propagate;
-  bool is_sat = true;
 
   std::vector<dpll_decision> decisions;
-  // kick start
-  decisions.emplace_back(-1, true);
+  if (checkpoint && checkpoint->resume) {
+    checkpoint->replay(decisions, I, xe, budget.stats);
+  } else {
+    // kick start
+    decisions.emplace_back(-1, true);
+  }
 
   while (true) {
+    // every iteration scans the clauses, a check per iteration is cheap.
+    // the top decision is not propagated yet, the state a snapshot holds
+    if (budget.exhausted(decisions.size() - 1)) {
+      if (checkpoint && !checkpoint->path.empty()) checkpoint->save(decisions, budget.stats);
+      return runknown;
+    }
+    if (checkpoint && !checkpoint->path.empty() && budget.elapsed() >= checkpoint->next) {
+      checkpoint->save(decisions, budget.stats);
+      checkpoint->next = budget.elapsed() + checkpoint->interval;
+    }
+
     // I->quick_print();
-    can_propagate = unit_propagate_all(cnf, I, decisions.back());
+    can_propagate = propagate_all(cnf, I, decisions.back(), xe, bins, Logger);
 
     if (!can_propagate) {
       // has conflict
-      bool backtrack_success = false;
-      // find the last decision that has not yet been flipped and flip it
-      while (decisions.size() > 1) {
-        dpll_decision &last_decision = decisions.back();
-        if (!last_decision.has_been_flipped) {
-          last_decision.flip_decision();
-          backtrack_success = true;
-          I->update(last_decision.decision_var, last_decision.decision_asmt);
-          Logger->log_redecision(decisions.back());
-          break;
-        } else {
-          Logger->log_backtrack(nullptr);
-          I->update(last_decision.decision_var, vundef);
-          decisions.pop_back();
-        }
-      }
-
-      if (backtrack_success) {
+      budget.stats.conflicts++;
+      if (backtrack(decisions, I, xe, Logger)) {
         continue;
       } else {
         // backtrack fail, no sat assignment
-        return false;
+        return runsat;
       }
     }
+
+    // pure literals satisfy clauses without falsifying any, so they never
+    // cause units or conflicts
+    lit pure_lit;
+    while (pure && pure->next_pure(I, &pure_lit)) {
+      budget.stats.pure_literals++;
+      Logger->log_pure(lit_var(pure_lit), lit_is_pos(pure_lit));
+      I->update(lit_var(pure_lit), lit_is_pos(pure_lit));
+      decisions.back().add_propagation(lit_var(pure_lit), lit_is_pos(pure_lit));
+    }
     
     can_decide = decide(cnf, I, &undef_var, &undef_sat_interp);
+    lit open_lit;
+    if (!can_decide && bins && bins->pick_open(I, &open_lit)) {
+      // the long clauses are done, but binary ones may still be open
+      undef_var = lit_var(open_lit);
+      undef_sat_interp = lit_is_pos(open_lit);
+      can_decide = true;
+    }
+    if (!can_decide && xe) {
+      // clauses are done, but XOR variables may still be open
+      undef_var = xe->pick_unassigned(I);
+      undef_sat_interp = true;
+      can_decide = undef_var >= 0;
+    }
     if (!can_decide) break;
 
     // make the decision
     // undef_sat_interp = true; // uncomment this line to always decide true first
+    if (xe) xe->push_level();
+    budget.stats.decisions++;
     decisions.emplace_back(undef_var, undef_sat_interp);
     I->update(undef_var, undef_sat_interp);
     Logger->log_decision(decisions.back());
   }
 
-  return true;
+  return rsat;
 }
 
-bool dpll_sat(CNF *cnf, int num_vars, assignment &result, std::ostream &output_pref) {
-  output = &output_pref;
-  Logger = new dpll_logger(*output);
+// Enumeration decides every primitive variable, lowest first, before any
+// auxiliary one. Once the primitive variables are fixed the Tseitin
+// auxiliaries follow by propagation, so the search tree has exactly one
+// leaf per model over the primitive variables and we can keep
+// backtracking after each model instead of restarting.
+bool decide_enum(CNF *cnf, Interp *I, int num_primitive_vars, int *undef_var, bool *undef_sat_interp) {
+  for (int v = 0; v < num_primitive_vars; v++) {
+    if (I->value(v) == vundef) {
+      *undef_var = v;
+      *undef_sat_interp = true;
+      return true;
+    }
+  }
 
-  Interp *I = new Interp(num_vars);
+  return decide(cnf, I, undef_var, undef_sat_interp);
+}
+
+uint64_t dpll_enumerate_main(CNF *cnf, Interp *I, int num_primitive_vars, uint64_t limit,
+                             model_callback &on_model, dpll_logger *Logger) {
+  int undef_var;
+  bool undef_sat_interp;
+  uint64_t num_models = 0;
+  assignment model;
+
+  std::vector<dpll_decision> decisions;
+  // kick start
+  decisions.emplace_back(-1, true);
 
-  bool is_sat = dpll_main(cnf, I);
+  while (true) {
+    bool has_conflict = !unit_propagate_all(cnf, I, decisions.back(), nullptr, Logger);
 
-  if (is_sat) {
+    if (!has_conflict) {
+      if (decide_enum(cnf, I, num_primitive_vars, &undef_var, &undef_sat_interp)) {
+        decisions.emplace_back(undef_var, undef_sat_interp);
+        I->update(undef_var, undef_sat_interp);
+        Logger->log_decision(decisions.back());
+        continue;
+      }
+
+      // a flipped decision can falsify a blocking clause outright
+      Clause *offending_clause;
+      if (interpret_cnf(cnf, I, &offending_clause) == vfalse) {
+        Logger->log_backtrack(offending_clause);
+        has_conflict = true;
+      }
+    }
+
+    if (!has_conflict) {
+      num_models++;
+      sat_interp_to_assignment(I, model);
+      if (!on_model(model) || num_models == limit) return num_models;
+
+      // decisions on auxiliary variables could lead back to the same
+      // primitive assignment, block it explicitly then
+      bool has_aux_decision = false;
+      for (auto it = decisions.begin() + 1; it != decisions.end(); it++) {
+        if (it->decision_var >= num_primitive_vars) has_aux_decision = true;
+      }
+      if (has_aux_decision) {
+        Clause *blocking = new Clause();
+        for (int v = 0; v < num_primitive_vars; v++) {
+          blocking->literals.push_back(mk_lit(v, !model[v]));
+        }
+        cnf->clauses.push_back(blocking);
+      }
+    }
+
+    // explore the next branch, as if the model were a conflict
+    if (!backtrack(decisions, I, nullptr, Logger)) return num_models;
+  }
+}
+
+// deletes the clause objects dpll_solve made for the binaries of cnf_in,
+// which follow the clauses of cnf_in in cnf
+static void free_binary_copies(CNF *cnf, CNF *cnf_in) {
+  if (cnf == cnf_in) return;
+  for (size_t i = cnf_in->clauses.size(); i < cnf->clauses.size(); i++) delete cnf->clauses[i];
+  delete cnf;
+}
+
+solve_result dpll_solve(CNF *cnf, int num_vars, const dpll_options &opts, dpll_stats &stats,
+                        assignment &result, std::ostream &output_pref, dpll_control *control) {
+  std::vector<std::pair<lit, lit> > no_binaries;
+  return dpll_solve(cnf, no_binaries, num_vars, opts, stats, result, output_pref, control);
+}
+
+solve_result dpll_solve(CNF *cnf_in, const std::vector<std::pair<lit, lit> > &binaries, int num_vars,
+                        const dpll_options &opts, dpll_stats &stats, assignment &result,
+                        std::ostream &output_pref, dpll_control *control) {
+  dpll_budget budget(opts.limits, control, stats);
+  bool use_bitset = opts.use_bitset && !opts.use_xor && !opts.use_symmetry &&
+                    opts.checkpoint_path.empty() && opts.resume_path.empty() &&
+                    num_vars <= BITSET_MAX_VARS;
+
+  // only the search with the binary graph takes the binaries as they are,
+  // every other stage gets them back as clause objects
+  CNF *cnf = cnf_in;
+  if (!binaries.empty() &&
+      (use_bitset || opts.use_xor || opts.use_symmetry || !opts.use_binary_graph)) {
+    cnf = new CNF();
+    cnf->clauses = cnf_in->clauses;
+    for (auto b = binaries.begin(); b != binaries.end(); b++) {
+      Clause *C = new Clause();
+      C->literals.push_back(b->first);
+      C->literals.push_back(b->second);
+      cnf->clauses.push_back(C);
+    }
+  }
+  // binaries that have no clause object in cnf
+  std::vector<std::pair<lit, lit> > no_binaries;
+  const std::vector<std::pair<lit, lit> > &loose = cnf == cnf_in ? binaries : no_binaries;
+
+  // small instances skip the general machinery, and with it the trace
+  if (use_bitset) {
+    output_pref << "Searching on bitmasks, without a trace (--no-bitset shows it)" << std::endl;
+    solve_result res = bitset_solve(cnf, num_vars, budget, result);
+    free_binary_copies(cnf, cnf_in);
+    stats.seconds = budget.elapsed();
+    stats.peak_memory_bytes = peak_memory_bytes();
+    return res;
+  }
+
+  dpll_logger *Logger = new dpll_logger(output_pref);
+
+  // the symmetry breaking clauses use variables of their own, which are
+  // dropped from the model again
+  int solve_vars = num_vars;
+  CNF *breaking = nullptr;
+  CNF *with_breaking = cnf;
+  if (opts.use_symmetry) {
+    breaking = new CNF();
+    solve_vars = break_symmetries(cnf, num_vars, opts.symmetry_max_seconds, breaking,
+                                  stats.symmetry);
+    output_pref << "Broke " << stats.symmetry.generators << " symmetry generators with "
+                << stats.symmetry.clauses << " lex-leader clauses in "
+                << stats.symmetry.seconds << " s" << std::endl;
+    if (!breaking->clauses.empty()) {
+      with_breaking = new CNF();
+      with_breaking->clauses = cnf->clauses;
+      with_breaking->clauses.insert(with_breaking->clauses.end(), breaking->clauses.begin(),
+                                    breaking->clauses.end());
+    }
+  }
+
+  Interp *I = new Interp(solve_vars);
+
+  CNF *clauses = with_breaking;
+  xor_engine *xe = nullptr;
+  if (opts.use_xor) {
+    std::vector<xor_constraint> xors;
+    clauses = new CNF();
+    extract_xors(with_breaking, XOR_MAX_RECOVER_SIZE, xors, clauses);
+    output_pref << "Recovered " << xors.size() << " XOR constraints from "
+                << (with_breaking->clauses.size() - clauses->clauses.size()) << " clauses"
+                << std::endl;
+    if (!xors.empty()) {
+      xe = new xor_engine(xors, solve_vars);
+      I->observers.push_back(xe);
+    }
+  }
+
+  pure_literal_counter *pure = nullptr;
+  if (opts.use_pure_literals) {
+    pure = new pure_literal_counter(clauses, loose, solve_vars, xe);
+    I->observers.push_back(pure);
+  }
+
+  // the search scans no clause objects for the binary clauses; a caller
+  // that split them off beforehand keeps none at all
+  CNF *search_clauses = clauses;
+  implication_graph *bins = nullptr;
+  if (opts.use_binary_graph) {
+    std::vector<std::pair<lit, lit> > all_binaries(loose);
+    search_clauses = new CNF();
+    extract_binaries(clauses, all_binaries, search_clauses);
+    bins = new implication_graph(all_binaries, solve_vars);
+  }
+
+  dpll_checkpointer *checkpoint = nullptr;
+  dpll_snapshot resume;
+  if (!opts.checkpoint_path.empty() || !opts.resume_path.empty()) {
+    checkpoint = new dpll_checkpointer();
+    checkpoint->path = opts.checkpoint_path;
+    checkpoint->interval = opts.checkpoint_interval;
+    checkpoint->next = opts.checkpoint_interval;
+    checkpoint->cnf_hash = cnf_fingerprint(search_clauses, solve_vars);
+    checkpoint->num_vars = solve_vars;
+    checkpoint->resume = nullptr;
+    // a snapshot of another CNF, or of other options, would not be sound
+    if (!opts.resume_path.empty() && read_snapshot(opts.resume_path, resume) &&
+        resume.cnf_hash == checkpoint->cnf_hash && resume.num_vars == solve_vars) {
+      checkpoint->resume = &resume;
+      output_pref << "Resuming from " << resume.levels.size() - 1 << " decisions in "
+                  << opts.resume_path << std::endl;
+    }
+  }
+
+  solve_result res = dpll_main(search_clauses, I, xe, bins, pure, budget, checkpoint, Logger);
+
+  if (res == rsat) {
     sat_interp_to_assignment(I, result);
+    result.resize(num_vars);
   }
+  stats.seconds = budget.elapsed();
+  stats.peak_memory_bytes = peak_memory_bytes();
   
+  delete checkpoint;
+  if (search_clauses != clauses) delete search_clauses;
+  delete bins;
+  if (clauses != with_breaking) delete clauses;
+  if (with_breaking != cnf) delete with_breaking;
+  if (breaking) free_cnf(breaking);
+  free_binary_copies(cnf, cnf_in);
+  delete pure;
+  delete xe;
+  delete I;
+  delete Logger;
+  return res;
+}
+
+dpll_job::dpll_job(CNF *cnf, const std::vector<std::pair<lit, lit> > &binaries, int num_vars,
+                   const dpll_options &opts, progress_callback progress,
+                   double progress_interval) {
+  control.progress = progress;
+  control.progress_interval = progress_interval;
+  const std::vector<std::pair<lit, lit> > *bins = &binaries;
+  future = std::async(std::launch::async, [this, cnf, bins, num_vars, opts]() {
+    null_buffer nb;
+    std::ostream null_stream(&nb);
+    return dpll_solve(cnf, *bins, num_vars, opts, job_stats, job_model, null_stream, &control);
+  });
+}
+
+dpll_job::~dpll_job() {
+  cancel();
+  if (future.valid()) future.wait();
+}
+
+bool dpll_job::wait_for(double seconds) {
+  return future.wait_for(std::chrono::duration<double>(seconds)) == std::future_status::ready;
+}
+
+solve_result dpll_job::get() {
+  return future.get();
+}
+
+dpll_job *dpll_solve_async(CNF *cnf, const std::vector<std::pair<lit, lit> > &binaries,
+                           int num_vars, const dpll_options &opts,
+                           progress_callback progress, double progress_interval) {
+  return new dpll_job(cnf, binaries, num_vars, opts, progress, progress_interval);
+}
+
+bool dpll_sat(CNF *cnf, int num_vars, const dpll_options &opts,
+              assignment &result, std::ostream &output_pref) {
+  dpll_options unlimited = opts;
+  unlimited.limits = dpll_limits();
+  dpll_stats stats;
+  return dpll_solve(cnf, num_vars, unlimited, stats, result, output_pref) == rsat;
+}
+
+bool dpll_sat(CNF *cnf, int num_vars, assignment &result, std::ostream &output_pref) {
+  return dpll_sat(cnf, num_vars, dpll_options(), result, output_pref);
+}
+
+uint64_t dpll_enumerate(CNF *cnf, int num_vars, int num_primitive_vars, uint64_t limit,
+                        model_callback on_model, std::ostream &output_pref) {
+  dpll_logger *Logger = new dpll_logger(output_pref);
+  Interp *I = new Interp(num_vars);
+
+  // blocking clauses go into a private copy of the clause list
+  CNF *work = new CNF(*cnf);
+  size_t num_original = work->clauses.size();
+
+  uint64_t num_models = dpll_enumerate_main(work, I, num_primitive_vars, limit, on_model, Logger);
+
+  for (size_t i = num_original; i < work->clauses.size(); i++) delete work->clauses[i];
+  delete work;
   delete I;
   delete Logger;
-  return is_sat;
+  return num_models;
 }
 
 void print_assignment(assignment &asmt, rmap_t* Rmap, int num_vars) {
@@ -1,13 +1,267 @@
 #ifndef DPLL_H
 #define DPLL_H
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "cnf.h"
 #include "parser.h"
+#include "symmetry.h"
 
 typedef std::vector<bool> assignment;
 
+// outcome of a solve; runknown when a solver gives up without an answer
+enum solve_result {rsat, runsat, runknown};
+
 void print_assignment(assignment &asmt, rmap_t* Rmap, int num_vars);
 
+// resource limits of a solve, 0 for no limit
+struct dpll_limits {
+  double max_seconds;
+  uint64_t max_decisions;
+  uint64_t max_conflicts;
+  // resident memory the process gains during the solve
+  size_t max_memory_bytes;
+
+  dpll_limits() : max_seconds(0), max_decisions(0), max_conflicts(0), max_memory_bytes(0) {}
+};
+
+// the limit that stopped a solve, or a cancel request
+enum limit_kind {no_limit, time_limit, decision_limit, conflict_limit, memory_limit, cancelled};
+
+const char *limit_name(limit_kind kind);
+
+struct dpll_stats {
+  uint64_t decisions;
+  uint64_t conflicts;
+  // variables set by the pure literal rule
+  uint64_t pure_literals;
+  double seconds;
+  size_t peak_memory_bytes;
+  limit_kind stopped_by;
+  // the symmetry breaking stage, when enabled
+  symmetry_stats symmetry;
+  // snapshots written, and whether the search went on from one
+  size_t checkpoints;
+  size_t checkpoint_failures;
+  bool resumed;
+
+  dpll_stats() :
+    decisions(0), conflicts(0), pure_literals(0), seconds(0), peak_memory_bytes(0),
+    stopped_by(no_limit), checkpoints(0), checkpoint_failures(0), resumed(false) {}
+};
+
+struct dpll_options {
+  // recover XOR constraints from the clauses and propagate them natively
+  bool use_xor;
+  // set variables that occur with one polarity only in the open clauses
+  bool use_pure_literals;
+  // keep the binary clauses as implication lists indexed by literal
+  bool use_binary_graph;
+  // solve instances of up to BITSET_MAX_VARS variables on bitmasks
+  bool use_bitset;
+  // add lex-leader clauses for the symmetries of the CNF before the search
+  bool use_symmetry;
+  // time cap of the symmetry search, 0 for none
+  double symmetry_max_seconds;
+  // write the search state there every checkpoint_interval seconds and
+  // when a limit stops the search, none if empty
+  std::string checkpoint_path;
+  double checkpoint_interval;
+  // go on from the snapshot there, if it was taken on the same search
+  std::string resume_path;
+  dpll_limits limits;
+
+  dpll_options() :
+    use_xor(false), use_pure_literals(true), use_binary_graph(true), use_bitset(true),
+    use_symmetry(false), symmetry_max_seconds(10), checkpoint_interval(300) {}
+};
+
+// a null buffer for the solver trace
+class null_buffer : public std::streambuf {
+public:
+  int overflow(int c) {return c;}
+};
+
+// snapshot of a running search
+struct dpll_progress {
+  uint64_t decisions;
+  uint64_t conflicts;
+  // decisions on the current branch
+  size_t depth;
+  double seconds;
+};
+
+typedef std::function<void(const dpll_progress &)> progress_callback;
+
+// Control of a solve from outside. cancel may be set from any thread; the
+// search stops before its next step with runknown and stopped_by set to
+// cancelled. progress, if set, is called on the solving thread at most
+// every progress_interval seconds.
+struct dpll_control {
+  std::atomic<bool> cancel;
+  progress_callback progress;
+  double progress_interval;
+
+  dpll_control() : cancel(false), progress_interval(1) {}
+};
+
+// peak resident set size of the process
+size_t peak_memory_bytes();
+// current resident set size of the process, the peak where it cannot be read
+size_t current_memory_bytes();
+
+// search iterations between checks of the clock and memory use
+#define BUDGET_CHECK_INTERVAL 64
+
+// Keeps the search within its limits. The counters are compared on every
+// check, the clock and memory use only every BUDGET_CHECK_INTERVAL checks.
+class dpll_budget {
+  const dpll_limits &limits;
+  dpll_control *control;
+  std::chrono::steady_clock::time_point start;
+  double next_progress;
+  unsigned checks;
+  // resident memory before the solve, not charged to it
+  size_t base_memory;
+
+  bool stop(limit_kind kind) {
+    stats.stopped_by = kind;
+    return true;
+  }
+
+  // cancellation and progress, only paid for when a control is attached
+  bool controlled(size_t depth) {
+    if (control->cancel.load(std::memory_order_relaxed)) return stop(cancelled);
+    if (control->progress) {
+      double now = elapsed();
+      if (now >= next_progress) {
+        next_progress = now + control->progress_interval;
+        dpll_progress p = {stats.decisions, stats.conflicts, depth, now};
+        control->progress(p);
+      }
+    }
+    return false;
+  }
+
+public:
+  dpll_stats &stats;
+
+  dpll_budget(const dpll_limits &l, dpll_control *c, dpll_stats &s) :
+    limits(l), control(c), start(std::chrono::steady_clock::now()), next_progress(0), checks(0),
+    base_memory(l.max_memory_bytes ? current_memory_bytes() : 0), stats(s) {
+    if (control) next_progress = control->progress_interval;
+  }
+
+  // depth is the number of decisions on the current branch
+  bool exhausted(size_t depth) {
+    if (control && controlled(depth)) return true;
+    if (limits.max_decisions && stats.decisions >= limits.max_decisions) {
+      return stop(decision_limit);
+    }
+    if (limits.max_conflicts && stats.conflicts >= limits.max_conflicts) {
+      return stop(conflict_limit);
+    }
+
+    if (++checks % BUDGET_CHECK_INTERVAL != 0) return false;
+    if (limits.max_seconds > 0 && elapsed() >= limits.max_seconds) {
+      return stop(time_limit);
+    }
+    if (limits.max_memory_bytes && used_memory() >= limits.max_memory_bytes) {
+      return stop(memory_limit);
+    }
+    return false;
+  }
+
+  double elapsed() const {
+    std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  // what the process holds beyond what it held when the solve started, so
+  // that earlier solves and the front end are not charged to this one
+  size_t used_memory() const {
+    size_t now = current_memory_bytes();
+    return now > base_memory ? now - base_memory : 0;
+  }
+};
+
+// Returns runknown, with stats.stopped_by set, when a limit is reached
+// before the search finishes. stats holds the search effort either way.
+solve_result dpll_solve(CNF *cnf, int num_vars, const dpll_options &opts, dpll_stats &stats,
+                        assignment &result, std::ostream &output_pref,
+                        dpll_control *control = nullptr);
+
+// The same for the clauses of cnf together with binaries, binary clauses
+// the caller has already taken out of cnf (see split_binaries). With the
+// binary graph they go into it without ever being clause objects; the
+// stages that need clause objects get temporary ones.
+solve_result dpll_solve(CNF *cnf, const std::vector<std::pair<lit, lit> > &binaries, int num_vars,
+                        const dpll_options &opts, dpll_stats &stats, assignment &result,
+                        std::ostream &output_pref, dpll_control *control = nullptr);
+
+// A dpll_solve running on a thread of its own. cnf and binaries must stay
+// alive and unchanged until the job has finished. Deleting the job cancels
+// the solve and waits for it.
+class dpll_job {
+  dpll_control control;
+  dpll_stats job_stats;
+  assignment job_model;
+  std::future<solve_result> future;
+
+public:
+  dpll_job(CNF *cnf, const std::vector<std::pair<lit, lit> > &binaries, int num_vars,
+           const dpll_options &opts, progress_callback progress, double progress_interval);
+  ~dpll_job();
+  dpll_job(const dpll_job &) = delete;
+  dpll_job &operator=(const dpll_job &) = delete;
+
+  // asks the solve to stop; safe from any thread, also after it finished
+  void cancel() {
+    control.cancel = true;
+  }
+
+  // waits up to seconds, true once the solve has finished
+  bool wait_for(double seconds);
+
+  // waits for the solve and returns its result; call once
+  solve_result get();
+
+  // valid after get(): the model when the result is rsat, and the effort
+  const assignment &model() const {
+    return job_model;
+  }
+  const dpll_stats &stats() const {
+    return job_stats;
+  }
+};
+
+// starts dpll_solve on cnf and binaries in the background; progress may
+// be empty
+dpll_job *dpll_solve_async(CNF *cnf, const std::vector<std::pair<lit, lit> > &binaries,
+                           int num_vars, const dpll_options &opts,
+                           progress_callback progress = progress_callback(),
+                           double progress_interval = 1);
+
+// without limits; runknown cannot happen then
+bool dpll_sat(CNF *cnf, int num_vars, const dpll_options &opts,
+              assignment &result, std::ostream &output_pref);
 bool dpll_sat(CNF *cnf, int num_vars, assignment &result, std::ostream &output_pref);
 
+// called with every model found; return false to stop the enumeration
+typedef std::function<bool(assignment &)> model_callback;
+
+// Streams every distinct model over variables 0..num_primitive_vars-1 to
+// on_model, stopping after limit models (0 for no limit). Returns the number
+// of models reported.
+uint64_t dpll_enumerate(CNF *cnf, int num_vars, int num_primitive_vars, uint64_t limit,
+                        model_callback on_model, std::ostream &output_pref);
+
 #endif /* DPLL_H */
@@ -3,12 +3,15 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 enum Connective {land, lor, limply, lequiv};
 
+enum CardinalityBound {atmost, atleast, exactly};
+
 class Formula {
 public:
-  enum Type {variable, negated, binary};
+  enum Type {variable, negated, binary, cardinality};
 
   Type type;
   virtual void print(std::ostream& os) const = 0;
@@ -17,9 +20,14 @@ public:
     f.print(os);
     return os;
   }
+  // a formula owns its subformulas, except variables: their nodes are
+  // shared between occurrences and owned by the parse result
+  virtual ~Formula() {}
+  static void release(Formula *f) {
+    if (f && f->type != variable) delete f;
+  }
 protected:
   Formula(Type t) : type(t) {}
-  virtual ~Formula() {}
 };
 
 class Variable : public Formula {
@@ -44,6 +52,9 @@ public:
 
   Negated(Formula *fa) :
     Formula(negated), f(fa) {}
+  virtual ~Negated() {
+    release(f);
+  }
 
   virtual void print(std::ostream& os) const {
     os << "!";
@@ -63,6 +74,10 @@ public:
 
   Binary(Formula *left, Formula *right, Connective conn) :
     Formula(binary), l(left), r(right), op(conn) {}
+  virtual ~Binary() {
+    release(l);
+    release(r);
+  }
 
   virtual void print(std::ostream& os) const {
     os << "(";
@@ -108,4 +123,55 @@ public:
   }
 };
 
+// at most / at least / exactly k of the operands are true
+class Cardinality : public Formula {
+public:
+  CardinalityBound bound;
+  int k;
+  std::vector<Formula *> operands;
+
+  Cardinality(CardinalityBound b, int kk) :
+    Formula(cardinality), bound(b), k(kk) {}
+  virtual ~Cardinality() {
+    for (auto it = operands.begin(); it != operands.end(); it++) release(*it);
+  }
+
+  static const char *keyword(CardinalityBound b) {
+    switch (b) {
+      case atmost:
+        return "atmost";
+      case atleast:
+        return "atleast";
+      case exactly:
+        return "exactly";
+    }
+    return "";
+  }
+
+  virtual void print(std::ostream& os) const {
+    os << keyword(bound) << "(" << k;
+    for (auto it = operands.begin(); it != operands.end(); it++) {
+      os << ",";
+      (*it)->print(os);
+    }
+    os << ")";
+  }
+  virtual void print_tree(std::string prefix) const {
+    switch (bound) {
+      case atmost:
+        std::cout << prefix << "AT MOST " << k << std::endl;
+        break;
+      case atleast:
+        std::cout << prefix << "AT LEAST " << k << std::endl;
+        break;
+      case exactly:
+        std::cout << prefix << "EXACTLY " << k << std::endl;
+        break;
+    }
+    for (auto it = operands.begin(); it != operands.end(); it++) {
+      (*it)->print_tree(prefix + "  ");
+    }
+  }
+};
+
 #endif /* FORMULA_H */
@@ -0,0 +1,58 @@
+#include "implication.h"
+
+void extract_binaries(CNF *cnf, std::vector<std::pair<lit, lit> > &binaries, CNF *rest) {
+  for (auto C = cnf->clauses.begin(); C != cnf->clauses.end(); C++) {
+    std::vector<lit> &lits = (*C)->literals;
+    if (lits.size() == 2 && lit_var(lits[0]) != lit_var(lits[1])) {
+      binaries.emplace_back(lits[0], lits[1]);
+    } else {
+      rest->clauses.push_back(*C);
+    }
+  }
+}
+
+void split_binaries(CNF *cnf, std::vector<std::pair<lit, lit> > &binaries) {
+  size_t kept = 0;
+  for (size_t i = 0; i < cnf->clauses.size(); i++) {
+    Clause *C = cnf->clauses[i];
+    std::vector<lit> &lits = C->literals;
+    if (lits.size() == 2 && lit_var(lits[0]) != lit_var(lits[1])) {
+      binaries.emplace_back(lits[0], lits[1]);
+      delete C;
+    } else {
+      cnf->clauses[kept++] = C;
+    }
+  }
+  cnf->clauses.resize(kept);
+  cnf->clauses.shrink_to_fit();
+}
+
+implication_graph::implication_graph(const std::vector<std::pair<lit, lit> > &binaries,
+                                     int num_vars) :
+  start(2 * num_vars + 1, 0), implied(2 * binaries.size()) {
+  for (auto b = binaries.begin(); b != binaries.end(); b++) {
+    start[lit_neg(b->first) + 1]++;
+    start[lit_neg(b->second) + 1]++;
+  }
+  for (size_t L = 0; L + 1 < start.size(); L++) start[L + 1] += start[L];
+
+  std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+  for (auto b = binaries.begin(); b != binaries.end(); b++) {
+    implied[fill[lit_neg(b->first)]++] = b->second;
+    implied[fill[lit_neg(b->second)]++] = b->first;
+  }
+}
+
+bool implication_graph::pick_open(const Interp *I, lit *L) const {
+  for (lit T = 0; T + 1 < start.size(); T++) {
+    if (I->satisfies(T) != vundef) continue;
+    for (const lit *l = begin(T); l != end(T); l++) {
+      // the clause (!T | l) is open
+      if (I->satisfies(*l) == vundef) {
+        *L = *l;
+        return true;
+      }
+    }
+  }
+  return false;
+}
@@ -0,0 +1,48 @@
+#ifndef IMPLICATION_H
+#define IMPLICATION_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "cnf.h"
+#include "interp.h"
+
+// Moves the clauses of exactly two distinct, non-complementary literals
+// out of cnf into binaries. All other clauses are appended to rest.
+void extract_binaries(CNF *cnf, std::vector<std::pair<lit, lit> > &binaries, CNF *rest);
+
+// The same in place: the binary clauses are appended to binaries and
+// removed from cnf, and their clause objects are deleted.
+void split_binaries(CNF *cnf, std::vector<std::pair<lit, lit> > &binaries);
+
+// Binary clauses as implications, without a clause object each: (a | b)
+// is stored as b under !a and a under !b. The lists of all literals share
+// one array, so following an implication is a single read, and the
+// literal that implied a value is all there is to say about why.
+class implication_graph {
+  // the literals implied by L are implied[start[L] .. start[L + 1])
+  std::vector<uint32_t> start;
+  std::vector<lit> implied;
+
+public:
+  implication_graph(const std::vector<std::pair<lit, lit> > &binaries, int num_vars);
+
+  // number of binary clauses
+  size_t size() const {
+    return implied.size() / 2;
+  }
+
+  const lit *begin(lit L) const {
+    return implied.data() + start[L];
+  }
+  const lit *end(lit L) const {
+    return implied.data() + start[L + 1];
+  }
+
+  // a literal of some binary clause with both literals unassigned, false
+  // if every binary clause is satisfied
+  bool pick_open(const Interp *I, lit *L) const;
+};
+
+#endif /* IMPLICATION_H */
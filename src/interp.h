@@ -0,0 +1,86 @@
+#ifndef INTERP_H
+#define INTERP_H
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "cnf.h"
+
+// variable interpretation, one byte per literal
+enum vinterp : uint8_t {vtrue, vfalse, vundef};
+
+inline vinterp negate_vinterp(vinterp vi) {
+  switch (vi) {
+    case vtrue:
+      return vfalse;
+    case vfalse:
+      return vtrue;
+    default:
+      return vundef;
+  }
+}
+
+inline void print_vinterp(vinterp vi) {
+  switch (vi) {
+    case vtrue:
+      std::cout << "vtrue";
+      break;
+    case vfalse:
+      std::cout << "vfalse";
+      break;
+    case vundef:
+      std::cout << "vundef";
+      break;
+  }
+}
+
+// notified of every change of a variable's value
+class interp_observer {
+public:
+  virtual void on_update(int var, vinterp from, vinterp to) = 0;
+  virtual ~interp_observer() {}
+};
+
+// A full interpretation, indexed by packed literal so that the value of
+// either polarity is a single byte load
+struct Interp {
+  std::vector<vinterp> lit_vals;
+  std::vector<interp_observer *> observers;
+
+  Interp(size_t size) : lit_vals(2 * size, vundef) {}
+
+  size_t num_vars() const {
+    return lit_vals.size() / 2;
+  }
+
+  vinterp satisfies(lit L) const {
+    return lit_vals[L];
+  }
+
+  vinterp value(int var) const {
+    return lit_vals[mk_lit(var, true)];
+  }
+
+  void update(int var, vinterp vi) {
+    if (value(var) != vi) {
+      for (auto o = observers.begin(); o != observers.end(); o++) (*o)->on_update(var, value(var), vi);
+    }
+    lit_vals[mk_lit(var, true)] = vi;
+    lit_vals[mk_lit(var, false)] = negate_vinterp(vi);
+  }
+  void update(int var, bool vi) {
+    update(var, vi ? vtrue : vfalse);
+  }
+
+  void quick_print() {
+    std::cout << "[" << num_vars() << "] ";
+    for (size_t i = 0; i < num_vars(); i++) {
+      print_vinterp(value(i));
+      std::cout << " ";
+    }
+    std::cout << std::endl;
+  }
+};
+
+#endif /* INTERP_H */
@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "localsearch.h"
+
+// break values above this share the last probsat weight
+#define PROBSAT_MAX_BREAK 64
+
+// how often progress is written to the trace output
+#define LS_LOG_INTERVAL 1000000
+
+// Local search state. Clauses are flattened into one literal array; for
+// every clause we keep the number of true literals and the XOR of the
+// variables that make it true, so the single critical variable of a clause
+// with one true literal is known without a scan.
+class ls_state {
+  int num_vars;
+  std::vector<lit> lits;
+  std::vector<size_t> clause_start;        // clause c is lits[clause_start[c] .. clause_start[c+1])
+  std::vector<std::vector<int> > occ;      // literal -> clauses containing it
+
+  std::vector<bool> value;
+  std::vector<int> num_true;
+  std::vector<var> true_vars_xor;
+  std::vector<int> break_count;            // sat clauses that flipping v would falsify
+  std::vector<int> make_count;             // unsat clauses that flipping v would satisfy
+
+  std::vector<int> unsat;                  // unsat clause ids, in no particular order
+  std::vector<int> unsat_pos;              // clause -> index in unsat, or -1
+
+  void add_unsat(int c) {
+    unsat_pos[c] = unsat.size();
+    unsat.push_back(c);
+  }
+
+  void remove_unsat(int c) {
+    int last = unsat.back();
+    unsat[unsat_pos[c]] = last;
+    unsat_pos[last] = unsat_pos[c];
+    unsat.pop_back();
+    unsat_pos[c] = -1;
+  }
+
+  bool lit_true(lit L) const {
+    return value[lit_var(L)] == lit_is_pos(L);
+  }
+
+public:
+  bool has_empty_clause;
+
+  ls_state(CNF *cnf, int n) :
+    num_vars(n), occ(2 * n), value(n), break_count(n, 0), make_count(n, 0),
+    has_empty_clause(false) {
+    clause_start.push_back(0);
+
+    std::vector<lit> C;
+    for (auto it = cnf->clauses.begin(); it != cnf->clauses.end(); it++) {
+      // drop repeated literals and tautologies, both confuse the counters
+      C = (*it)->literals;
+      std::sort(C.begin(), C.end());
+      C.erase(std::unique(C.begin(), C.end()), C.end());
+
+      bool tautology = false;
+      for (size_t i = 1; i < C.size(); i++) {
+        if (C[i] == lit_neg(C[i - 1])) tautology = true;
+      }
+      if (tautology) continue;
+      if (C.empty()) has_empty_clause = true;
+
+      int c = clause_start.size() - 1;
+      for (auto L = C.begin(); L != C.end(); L++) {
+        lits.push_back(*L);
+        occ[*L].push_back(c);
+      }
+      clause_start.push_back(lits.size());
+    }
+  }
+
+  int num_clauses() const {
+    return clause_start.size() - 1;
+  }
+
+  int num_unsat() const {
+    return unsat.size();
+  }
+
+  int get_break(var v) const {
+    return break_count[v];
+  }
+
+  int get_make(var v) const {
+    return make_count[v];
+  }
+
+  const lit *clause_begin(int c) const {
+    return &lits[clause_start[c]];
+  }
+
+  const lit *clause_end(int c) const {
+    return &lits[0] + clause_start[c + 1];
+  }
+
+  int random_unsat(std::mt19937 &rng) const {
+    return unsat[std::uniform_int_distribution<int>(0, unsat.size() - 1)(rng)];
+  }
+
+  // start from a random assignment and rebuild every counter
+  void init(std::mt19937 &rng) {
+    std::bernoulli_distribution coin(0.5);
+    for (int v = 0; v < num_vars; v++) value[v] = coin(rng);
+
+    int m = num_clauses();
+    num_true.assign(m, 0);
+    true_vars_xor.assign(m, 0);
+    unsat.clear();
+    unsat_pos.assign(m, -1);
+    std::fill(break_count.begin(), break_count.end(), 0);
+    std::fill(make_count.begin(), make_count.end(), 0);
+
+    for (int c = 0; c < m; c++) {
+      for (const lit *L = clause_begin(c); L != clause_end(c); L++) {
+        if (lit_true(*L)) {
+          num_true[c]++;
+          true_vars_xor[c] ^= lit_var(*L);
+        }
+      }
+
+      if (num_true[c] == 0) {
+        add_unsat(c);
+        for (const lit *L = clause_begin(c); L != clause_end(c); L++) {
+          make_count[lit_var(*L)]++;
+        }
+      } else if (num_true[c] == 1) {
+        break_count[true_vars_xor[c]]++;
+      }
+    }
+  }
+
+  void flip(var v) {
+    lit now_false = mk_lit(v, value[v]);
+    lit now_true = lit_neg(now_false);
+    value[v] = !value[v];
+
+    const std::vector<int> &falsified = occ[now_false];
+    for (auto it = falsified.begin(); it != falsified.end(); it++) {
+      int c = *it;
+      num_true[c]--;
+      true_vars_xor[c] ^= v;
+
+      if (num_true[c] == 0) {
+        // v was critical, the clause is now unsat
+        break_count[v]--;
+        add_unsat(c);
+        for (const lit *L = clause_begin(c); L != clause_end(c); L++) {
+          make_count[lit_var(*L)]++;
+        }
+      } else if (num_true[c] == 1) {
+        // the remaining true variable became critical
+        break_count[true_vars_xor[c]]++;
+      }
+    }
+
+    const std::vector<int> &satisfied = occ[now_true];
+    for (auto it = satisfied.begin(); it != satisfied.end(); it++) {
+      int c = *it;
+      num_true[c]++;
+      true_vars_xor[c] ^= v;
+
+      if (num_true[c] == 1) {
+        // clause was unsat, v is now its critical variable
+        remove_unsat(c);
+        for (const lit *L = clause_begin(c); L != clause_end(c); L++) {
+          make_count[lit_var(*L)]--;
+        }
+        break_count[v]++;
+      } else if (num_true[c] == 2) {
+        // the previously critical variable no longer is
+        break_count[true_vars_xor[c] ^ v]--;
+      }
+    }
+  }
+
+  void to_assignment(assignment &asmt) const {
+    asmt.assign(value.begin(), value.end());
+  }
+};
+
+// WalkSAT/SKC: free moves first, else a random walk with probability noise,
+// else the least-breaking variable (ties broken by make count)
+var pick_walksat(ls_state &S, int c, const ls_options &opts, std::mt19937 &rng) {
+  const lit *begin = S.clause_begin(c);
+  const lit *end = S.clause_end(c);
+
+  var best = lit_var(*begin);
+  int best_break = S.get_break(best);
+  for (const lit *L = begin + 1; L != end; L++) {
+    var v = lit_var(*L);
+    int b = S.get_break(v);
+    if (b < best_break || (b == best_break && S.get_make(v) > S.get_make(best))) {
+      best = v;
+      best_break = b;
+    }
+  }
+
+  if (best_break == 0) return best;
+
+  if (std::bernoulli_distribution(opts.noise)(rng)) {
+    int n = end - begin;
+    return lit_var(begin[std::uniform_int_distribution<int>(0, n - 1)(rng)]);
+  }
+
+  return best;
+}
+
+// probSAT: pick each variable with probability proportional to cb^-break
+var pick_probsat(ls_state &S, int c, const std::vector<double> &weights, std::mt19937 &rng) {
+  const lit *begin = S.clause_begin(c);
+  const lit *end = S.clause_end(c);
+
+  double sum = 0;
+  double probs[PROBSAT_MAX_BREAK];
+  std::vector<double> big_probs;
+  int n = end - begin;
+  double *p = probs;
+  if (n > PROBSAT_MAX_BREAK) {
+    big_probs.resize(n);
+    p = big_probs.data();
+  }
+
+  for (int i = 0; i < n; i++) {
+    int b = std::min(S.get_break(lit_var(begin[i])), PROBSAT_MAX_BREAK - 1);
+    p[i] = weights[b];
+    sum += p[i];
+  }
+
+  double r = std::uniform_real_distribution<double>(0, sum)(rng);
+  for (int i = 0; i < n - 1; i++) {
+    r -= p[i];
+    if (r <= 0) return lit_var(begin[i]);
+  }
+  return lit_var(begin[n - 1]);
+}
+
+solve_result ls_sat(CNF *cnf, int num_vars, const ls_options &opts,
+                    assignment &result, std::ostream &output_pref) {
+  ls_state S(cnf, num_vars);
+  if (S.has_empty_clause) return runsat;
+
+  std::mt19937 rng(opts.seed);
+  S.init(rng);
+
+  std::vector<double> weights(PROBSAT_MAX_BREAK);
+  for (int b = 0; b < PROBSAT_MAX_BREAK; b++) weights[b] = std::pow(opts.cb, -b);
+
+  output_pref << "Local search (" << (opts.algorithm == walksat ? "walksat" : "probsat")
+              << ", seed " << opts.seed << "), " << S.num_unsat()
+              << " unsat clauses initially" << std::endl;
+
+  uint64_t flips = 0;
+  while (S.num_unsat() > 0) {
+    if (flips >= opts.max_flips) {
+      output_pref << "Flip budget exhausted with " << S.num_unsat()
+                  << " unsat clauses" << std::endl;
+      return runknown;
+    }
+
+    int c = S.random_unsat(rng);
+    var v = opts.algorithm == walksat ? pick_walksat(S, c, opts, rng)
+                                      : pick_probsat(S, c, weights, rng);
+    S.flip(v);
+    flips++;
+
+    if (flips % LS_LOG_INTERVAL == 0) {
+      output_pref << "  " << flips << " flips, " << S.num_unsat() << " unsat clauses" << std::endl;
+    }
+  }
+
+  output_pref << "Found a model after " << flips << " flips" << std::endl;
+  S.to_assignment(result);
+  return rsat;
+}
@@ -0,0 +1,31 @@
+#ifndef LOCALSEARCH_H
+#define LOCALSEARCH_H
+
+#include <cstdint>
+#include <ostream>
+
+#include "cnf.h"
+#include "dpll.h"
+
+enum ls_algorithm {walksat, probsat};
+
+struct ls_options {
+  ls_algorithm algorithm;
+  uint64_t max_flips;
+  unsigned seed;
+  // walksat: probability of a random walk step when every candidate breaks a clause
+  double noise;
+  // probsat: a variable is picked with weight cb^-break
+  double cb;
+
+  ls_options() :
+    algorithm(probsat), max_flips(100000000), seed(0), noise(0.567), cb(2.5) {}
+};
+
+// Stochastic local search. Returns rsat with a full model in result, or
+// runknown once the flip budget is exhausted (local search cannot prove
+// unsatisfiability, except for an empty clause).
+solve_result ls_sat(CNF *cnf, int num_vars, const ls_options &opts,
+                    assignment &result, std::ostream &output_pref);
+
+#endif /* LOCALSEARCH_H */
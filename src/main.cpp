@@ -1,21 +1,99 @@
+#include <getopt.h>
+#include <pthread.h>
 #include <unistd.h>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
 #include <ostream>
+#include <string>
+#include <thread>
 
 #include "formula.h"
 #include "parser.h"
 #include "cnf.h"
 #include "tseitin.h"
 #include "dpll.h"
+#include "verify.h"
+#include "checkpoint.h"
+#include "localsearch.h"
+#include "components.h"
+#include "count.h"
+#include "server.h"
+#include "cnfcache.h"
+#include "simplify.h"
+#include "dimacs.h"
+#include "circuit.h"
+#include "implication.h"
 
-#define INPUT_BUF_SIZE 256
+// ids for options that only have a long form
+enum long_only_option {
+  opt_local_search = 256,
+  opt_seed,
+  opt_max_flips,
+  opt_noise,
+  opt_cb,
+  opt_components,
+  opt_threads,
+  opt_count,
+  opt_cache_mb,
+  opt_enumerate,
+  opt_xor,
+  opt_time_limit,
+  opt_max_decisions,
+  opt_max_conflicts,
+  opt_max_memory,
+  opt_server,
+  opt_server_cache_mb,
+  opt_cnf_cache,
+  opt_no_pure_literals,
+  opt_no_binary_graph,
+  opt_no_bitset,
+  opt_no_simplify,
+  opt_dimacs,
+  opt_progress,
+  opt_symmetry,
+  opt_circuit,
+  opt_checkpoint,
+  opt_checkpoint_interval,
+  opt_resume,
+};
 
-class Logger {
-  // a null buffer for the null ostream
-  class null_buffer : public std::streambuf {
-  public:
-    int overflow(int c) {return c;}
-  };
+// set by SIGINT while a solve runs in the background
+static volatile std::sig_atomic_t interrupted = 0;
+
+static void on_interrupt(int) {
+  interrupted = 1;
+}
+
+// how often the main thread looks for an interrupt, in seconds
+#define INTERRUPT_POLL_SECONDS 0.05
+
+// Solves on a background job, printing its progress to stderr every
+// interval seconds. Ctrl-C cancels the search, which then ends UNKNOWN.
+static solve_result solve_with_progress(CNF *cnf, const std::vector<std::pair<lit, lit> > &binaries,
+                                        int num_vars, const dpll_options &opts, double interval,
+                                        dpll_stats &stats, assignment &result) {
+  interrupted = 0;
+  void (*previous)(int) = std::signal(SIGINT, on_interrupt);
+  dpll_job *job = dpll_solve_async(cnf, binaries, num_vars, opts, [](const dpll_progress &p) {
+      std::cerr << "c progress: " << p.seconds << " s, " << p.decisions << " decisions, "
+                << p.conflicts << " conflicts, depth " << p.depth << std::endl;
+    }, interval);
+  while (!job->wait_for(INTERRUPT_POLL_SECONDS)) {
+    if (interrupted) job->cancel();
+  }
+  std::signal(SIGINT, previous);
 
+  solve_result res = job->get();
+  stats = job->stats();
+  if (res == rsat) result = job->model();
+  delete job;
+  return res;
+}
+
+class Logger {
   null_buffer nb;
   std::ostream null_stream;
   int quietness;
@@ -34,23 +112,193 @@ public:
     }
     return null_stream;
   }
+
+  bool enabled(int level) {
+    return level <= quietness;
+  }
 };
 
+// the formula passes recurse on the tree, so a long chain like
+// a & b & c & ... from a large input needs a deep stack
+#define MAIN_STACK_SIZE (1UL << 30)
 
-int main(int argc, char **argv) {
+static void log_search_stats(Logger &logger, const dpll_stats &stats) {
+  logger.log(1) << std::endl << "Search: " << stats.decisions << " decisions, "
+                << stats.conflicts << " conflicts, " << stats.pure_literals
+                << " pure literals, " << stats.seconds << " s, peak memory "
+                << (stats.peak_memory_bytes >> 20) << " MB" << std::endl;
+}
+
+int sat_main(int argc, char **argv) {
 
   int quietness = 2;
   bool show_parse_tree = false;
+  bool verify_model = false;
+  bool use_local_search = false;
+  ls_options ls_opts;
+  bool split_into_components = false;
+  int num_threads = std::thread::hardware_concurrency();
+  bool count_mode = false;
+  count_options count_opts;
+  dpll_options dpll_opts;
+  bool enumerate_mode = false;
+  uint64_t enumerate_limit = 0;
+  bool server_mode = false;
+  server_options server_opts;
+  std::string cnf_cache_path;
+  bool simplify_formula = true;
+  std::string dimacs_path;
+  double progress_interval = 0;
+  bool use_circuit = false;
+
+  static struct option long_options[] = {
+    {"verify", no_argument, nullptr, 'v'},
+    {"local-search", optional_argument, nullptr, opt_local_search},
+    {"seed", required_argument, nullptr, opt_seed},
+    {"max-flips", required_argument, nullptr, opt_max_flips},
+    {"noise", required_argument, nullptr, opt_noise},
+    {"cb", required_argument, nullptr, opt_cb},
+    {"components", no_argument, nullptr, opt_components},
+    {"threads", required_argument, nullptr, opt_threads},
+    {"count", no_argument, nullptr, opt_count},
+    {"cache-mb", required_argument, nullptr, opt_cache_mb},
+    {"enumerate", optional_argument, nullptr, opt_enumerate},
+    {"xor", no_argument, nullptr, opt_xor},
+    {"time-limit", required_argument, nullptr, opt_time_limit},
+    {"max-decisions", required_argument, nullptr, opt_max_decisions},
+    {"max-conflicts", required_argument, nullptr, opt_max_conflicts},
+    {"max-memory", required_argument, nullptr, opt_max_memory},
+    {"server", optional_argument, nullptr, opt_server},
+    {"server-cache-mb", required_argument, nullptr, opt_server_cache_mb},
+    {"cnf-cache", required_argument, nullptr, opt_cnf_cache},
+    {"no-pure-literals", no_argument, nullptr, opt_no_pure_literals},
+    {"no-binary-graph", no_argument, nullptr, opt_no_binary_graph},
+    {"no-bitset", no_argument, nullptr, opt_no_bitset},
+    {"no-simplify", no_argument, nullptr, opt_no_simplify},
+    {"dimacs", required_argument, nullptr, opt_dimacs},
+    {"progress", optional_argument, nullptr, opt_progress},
+    {"symmetry", optional_argument, nullptr, opt_symmetry},
+    {"circuit", no_argument, nullptr, opt_circuit},
+    {"checkpoint", required_argument, nullptr, opt_checkpoint},
+    {"checkpoint-interval", required_argument, nullptr, opt_checkpoint_interval},
+    {"resume", required_argument, nullptr, opt_resume},
+    {nullptr, 0, nullptr, 0}
+  };
 
   int c;
-  while ((c = getopt(argc, argv, "qt")) != -1) {
+  while ((c = getopt_long(argc, argv, "qtv", long_options, nullptr)) != -1) {
     switch (c) {
       case 't':
         show_parse_tree = true;
         break;
+      case 'v':
+        verify_model = true;
+        break;
       case 'q':
         if (quietness > 0) quietness--;
         break;
+      case opt_local_search:
+        use_local_search = true;
+        if (!optarg || std::strcmp(optarg, "probsat") == 0) {
+          ls_opts.algorithm = probsat;
+        } else if (std::strcmp(optarg, "walksat") == 0) {
+          ls_opts.algorithm = walksat;
+        } else {
+          std::cerr << "Unknown local search algorithm: " << optarg << std::endl;
+          return 1;
+        }
+        break;
+      case opt_seed:
+        ls_opts.seed = std::strtoul(optarg, nullptr, 10);
+        break;
+      case opt_max_flips:
+        ls_opts.max_flips = std::strtoull(optarg, nullptr, 10);
+        break;
+      case opt_noise:
+        ls_opts.noise = std::atof(optarg);
+        break;
+      case opt_cb:
+        ls_opts.cb = std::atof(optarg);
+        break;
+      case opt_components:
+        split_into_components = true;
+        break;
+      case opt_threads:
+        num_threads = std::atoi(optarg);
+        break;
+      case opt_count:
+        count_mode = true;
+        break;
+      case opt_cache_mb:
+        count_opts.cache_bytes = std::strtoull(optarg, nullptr, 10) << 20;
+        break;
+      case opt_enumerate:
+        enumerate_mode = true;
+        if (optarg) enumerate_limit = std::strtoull(optarg, nullptr, 10);
+        break;
+      case opt_xor:
+        dpll_opts.use_xor = true;
+        break;
+      case opt_time_limit:
+        dpll_opts.limits.max_seconds = std::atof(optarg);
+        break;
+      case opt_max_decisions:
+        dpll_opts.limits.max_decisions = std::strtoull(optarg, nullptr, 10);
+        break;
+      case opt_max_conflicts:
+        dpll_opts.limits.max_conflicts = std::strtoull(optarg, nullptr, 10);
+        break;
+      case opt_max_memory:
+        dpll_opts.limits.max_memory_bytes = std::strtoull(optarg, nullptr, 10) << 20;
+        break;
+      case opt_server:
+        server_mode = true;
+        if (optarg) server_opts.socket_path = optarg;
+        break;
+      case opt_server_cache_mb:
+        server_opts.cache_bytes = std::strtoull(optarg, nullptr, 10) << 20;
+        break;
+      case opt_cnf_cache:
+        cnf_cache_path = optarg;
+        break;
+      case opt_no_pure_literals:
+        dpll_opts.use_pure_literals = false;
+        break;
+      case opt_no_binary_graph:
+        dpll_opts.use_binary_graph = false;
+        break;
+      case opt_no_bitset:
+        dpll_opts.use_bitset = false;
+        break;
+      case opt_no_simplify:
+        simplify_formula = false;
+        break;
+      case opt_dimacs:
+        dimacs_path = optarg;
+        break;
+      case opt_symmetry:
+        dpll_opts.use_symmetry = true;
+        if (optarg) dpll_opts.symmetry_max_seconds = std::atof(optarg);
+        break;
+      case opt_circuit:
+        use_circuit = true;
+        break;
+      case opt_checkpoint:
+        dpll_opts.checkpoint_path = optarg;
+        break;
+      case opt_checkpoint_interval:
+        dpll_opts.checkpoint_interval = std::atof(optarg);
+        if (dpll_opts.checkpoint_interval <= 0) dpll_opts.checkpoint_interval = 300;
+        break;
+      case opt_resume:
+        dpll_opts.resume_path = optarg;
+        break;
+      case opt_progress:
+        progress_interval = optarg ? std::atof(optarg) : 1;
+        if (progress_interval <= 0) progress_interval = 1;
+        break;
+      default:
+        return 1;
     }
   }
 
@@ -62,60 +310,247 @@ int main(int argc, char **argv) {
   Logger logger;
   logger.set_quietness(quietness);
 
-  char input[INPUT_BUF_SIZE];
-  std::cin.getline(input, INPUT_BUF_SIZE);
+  if (!dpll_opts.resume_path.empty()) {
+    dpll_snapshot snapshot;
+    if (!read_snapshot(dpll_opts.resume_path, snapshot)) {
+      logger.log(0) << "Cannot read the snapshot " << dpll_opts.resume_path << std::endl;
+      return 1;
+    }
+  }
 
-  /***********
-   * PARSING *
-   ***********/
-  parse_result *pr = parse_formula(input, input+INPUT_BUF_SIZE);
+  if (server_mode) {
+    server_opts.num_threads = num_threads;
+    server_opts.solver = dpll_opts;
+    // snapshots belong to a single solve
+    server_opts.solver.checkpoint_path.clear();
+    server_opts.solver.resume_path.clear();
+    return run_server(server_opts);
+  }
 
-  if (!pr->has_error()) {
-    logger.log(2) << "Parse complete. No errors." << std::endl;
-  } else {
-    logger.log(0) << "Parse Error:" << std::endl
-      << "  position: " << (pr->error_char_pos - input) << std::endl
-      << "  found: " << *pr->error_char_pos << std::endl
-      << "  expects: ";
-    switch (pr->expects) {
-      case 'e':
-        logger.log(0) << "an expression";
-        break;
-      case 'c':
-        logger.log(0) << "a binary operator";
-        break;
-      default:
-        logger.log(0) << "'" << pr->expects << "'";
+  // the whole of stdin is one formula
+  std::string input_text((std::istreambuf_iterator<char>(std::cin)),
+                         std::istreambuf_iterator<char>());
+  char *input = &input_text[0];
+
+  /*************
+   * CNF CACHE *
+   *************/
+  parse_result *pr = nullptr;
+  rmap_t *Rmap;
+  int num_primitive_vars;
+  CNF *cnf;
+  bool used_tseitin = false;
+  bool simplified = false;
+
+  // the other modes all work on the CNF
+  bool solve_circuit = use_circuit && !count_mode && !enumerate_mode && !use_local_search &&
+                       !split_into_components && dimacs_path.empty() &&
+                       dpll_opts.checkpoint_path.empty() && dpll_opts.resume_path.empty();
+
+  uint64_t input_hash = cnf_cache_input_hash(input, input_text.size());
+  bool from_cache = false;
+  // an export streams the CNF instead of building it and the circuit
+  // engine has no use for one, so neither needs a cached CNF
+  if (!cnf_cache_path.empty() && dimacs_path.empty() && !solve_circuit) {
+    cnf_cache_entry entry;
+    std::string reason;
+    from_cache = load_cnf_cache(cnf_cache_path, input_hash, simplify_formula, entry, &reason);
+    if (from_cache) {
+      cnf = entry.cnf;
+      Rmap = entry.Rmap;
+      num_primitive_vars = entry.num_primitive_vars;
+      used_tseitin = entry.used_tseitin;
+      logger.log(1) << "Loaded the CNF from " << cnf_cache_path
+                    << ", skipping parse and tseitin transform" << std::endl;
+    } else {
+      logger.log(1) << "Not using the CNF cache " << cnf_cache_path << ": " << reason << std::endl;
     }
-    logger.log(0) << std::endl;
-    return 0;
   }
 
-  logger.log(1) << std::endl <<"Parse result (disambiguated):" << std::endl << *(pr->f) << std::endl;
+  if (!from_cache) {
+    /***********
+     * PARSING *
+     ***********/
+    auto parse_start = std::chrono::steady_clock::now();
+    pr = parse_formula(input, input + input_text.size());
+    std::chrono::duration<double> parse_time = std::chrono::steady_clock::now() - parse_start;
 
-  if (show_parse_tree) {
-    logger.log(0) << std::endl << "Parse tree:" << std::endl;
-    pr->f->print_tree("");
-  }
+    if (!pr->has_error()) {
+      logger.log(2) << "Parse complete. No errors." << std::endl;
+      logger.log(2) << "Parsed " << input_text.size() << " bytes in " << parse_time.count() * 1000
+                    << " ms (" << input_text.size() / parse_time.count() / 1e6 << " MB/s)" << std::endl;
+    } else {
+      logger.log(0) << "Parse Error:" << std::endl
+        << "  position: " << (pr->error_char_pos - input) << std::endl
+        << "  found: ";
+      if (*pr->error_char_pos) logger.log(0) << *pr->error_char_pos;
+      else logger.log(0) << "end of input";
+      logger.log(0) << std::endl << "  expects: ";
+      switch (pr->expects) {
+        case 'e':
+          logger.log(0) << "an expression";
+          break;
+        case 'c':
+          logger.log(0) << "a binary operator";
+          break;
+        case 'n':
+          logger.log(0) << "a number";
+          break;
+        default:
+          logger.log(0) << "'" << pr->expects << "'";
+      }
+      logger.log(0) << std::endl;
+      return 0;
+    }
+
+    logger.log(1) << std::endl <<"Parse result (disambiguated):" << std::endl << *(pr->f) << std::endl;
 
-  vmap_t *Vmap = pr->Vmap;
-  rmap_t *Rmap = pr->Rmap;
-  int num_primitive_vars = Rmap->size();
+    if (show_parse_tree) {
+      logger.log(0) << std::endl << "Parse tree:" << std::endl;
+      pr->f->print_tree("");
+    }
 
-  /*************************
-   * TSEITIN CNF TRANSFORM *
-   *************************/
-  tseitin_init(Vmap, Rmap);
+    vmap_t *Vmap = pr->Vmap;
+    Rmap = pr->Rmap;
+    num_primitive_vars = Rmap->size();
 
-  CNF *cnf;
-  // attempt direct transform
-  cnf = parse_into_cnf(pr->f);
-  if (cnf) {
-    logger.log(1) << std::endl << "Recognized input as CNF. No tseitin tranform needed" << std::endl;
-  } else {
-    logger.log(1) << std::endl << "Did not recognize input as CNF. Performing tseitin transform" << std::endl;
-    // if cannot direct transform, perform full tseitin
-    cnf = tseitin_transform(pr->f);
+    /******************
+     * SIMPLIFICATION *
+     ******************/
+    // the formula the CNF is made from, the input one is kept for verification
+    Formula *formula = pr->f;
+    simplify_result sr;
+    sr.f = pr->f;
+    sr.value = true;
+    if (simplify_formula) {
+      auto simplify_start = std::chrono::steady_clock::now();
+      sr = simplify(pr->f);
+      std::chrono::duration<double> simplify_time = std::chrono::steady_clock::now() - simplify_start;
+      simplified = sr.stats.rewrites() > 0;
+      if (simplified) formula = sr.f;
+      logger.log(2) << std::endl << "Simplified " << sr.stats.nodes_before << " nodes to "
+                    << (sr.f ? sr.stats.nodes_after : 0) << " in " << simplify_time.count() * 1000
+                    << " ms (" << sr.stats.double_negations << " double negations, "
+                    << sr.stats.duplicates << " duplicates, " << sr.stats.complements
+                    << " complements, " << sr.stats.constants << " constants, "
+                    << sr.stats.absorptions << " absorptions)" << std::endl;
+      if (simplified) {
+        logger.log(1) << std::endl << "Simplified formula:" << std::endl;
+        if (formula) {
+          logger.log(1) << *formula << std::endl;
+        } else {
+          logger.log(1) << (sr.value ? "true" : "false") << std::endl;
+        }
+      }
+    }
+
+    /***************
+     * CIRCUIT SAT *
+     ***************/
+    if (solve_circuit) {
+      assignment result;
+      dpll_stats stats;
+      solve_result res;
+      logger.log(2) << std::endl << "Running the circuit engine over " << num_primitive_vars
+                    << " inputs..." << std::endl;
+      if (formula) {
+        res = circuit_solve(formula, num_primitive_vars, dpll_opts, stats, result, logger.log(2));
+      } else {
+        res = sr.value ? rsat : runsat;
+        result.assign(num_primitive_vars, true);
+      }
+      if (sr.f != pr->f) Formula::release(sr.f);
+
+      switch (res) {
+        case rsat:
+          logger.log(0) << std::endl << "SAT" << std::endl;
+          print_assignment(result, Rmap, num_primitive_vars);
+          break;
+        case runsat:
+          logger.log(0) << std::endl << "NON-SAT" << std::endl;
+          break;
+        case runknown:
+          logger.log(0) << std::endl << "UNKNOWN" << std::endl;
+          logger.log(1) << "Stopped by the " << limit_name(stats.stopped_by) << std::endl;
+          break;
+      }
+      log_search_stats(logger, stats);
+
+      if (verify_model && res == rsat) {
+        if (!verify_formula(pr->f, result)) {
+          logger.log(0) << std::endl << "VERIFICATION FAILED: model falsifies the input formula"
+                        << std::endl;
+          return 1;
+        }
+        logger.log(1) << std::endl << "Model verified against the input formula" << std::endl;
+      }
+      return 0;
+    }
+
+    /*************************
+     * TSEITIN CNF TRANSFORM *
+     *************************/
+    tseitin_init(Vmap, Rmap);
+
+    if (!dimacs_path.empty()) {
+      // write the clauses out as they are generated and stop
+      dimacs_writer writer;
+      if (!writer.open(dimacs_path, Rmap, num_primitive_vars)) {
+        logger.log(0) << std::endl << "Could not write " << dimacs_path << std::endl;
+        return 1;
+      }
+      auto export_start = std::chrono::steady_clock::now();
+      CNF *direct = formula ? parse_into_cnf(formula) : constant_cnf(sr.value);
+      if (direct) {
+        for (auto C = direct->clauses.begin(); C != direct->clauses.end(); C++) writer.add_clause(*C);
+        delete direct;
+      } else {
+        tseitin_transform(formula, num_threads, writer);
+      }
+      std::chrono::duration<double> export_time = std::chrono::steady_clock::now() - export_start;
+      if (sr.f != pr->f) Formula::release(sr.f);
+
+      if (!writer.finish(Rmap->size())) {
+        logger.log(0) << std::endl << "Could not write " << dimacs_path << std::endl;
+        return 1;
+      }
+      logger.log(1) << std::endl << "Wrote " << Rmap->size() << " variables and "
+                    << writer.clauses_written() << " clauses to " << dimacs_path << " in "
+                    << export_time.count() * 1000 << " ms" << std::endl;
+      return 0;
+    }
+
+    // attempt direct transform
+    cnf = formula ? parse_into_cnf(formula) : constant_cnf(sr.value);
+    if (cnf) {
+      logger.log(1) << std::endl << "Recognized input as CNF. No tseitin tranform needed" << std::endl;
+    } else {
+      logger.log(1) << std::endl << "Did not recognize input as CNF. Performing tseitin transform" << std::endl;
+      // if cannot direct transform, perform full tseitin
+      auto tseitin_start = std::chrono::steady_clock::now();
+      cnf = tseitin_transform(formula, num_threads);
+      std::chrono::duration<double> tseitin_time = std::chrono::steady_clock::now() - tseitin_start;
+      used_tseitin = true;
+      logger.log(2) << "Transformed into " << cnf->clauses.size() << " clauses over "
+                    << Rmap->size() << " variables in " << tseitin_time.count() * 1000 << " ms"
+                    << std::endl;
+    }
+
+    if (sr.f != pr->f) Formula::release(sr.f);
+
+    if (!cnf_cache_path.empty()) {
+      cnf_cache_entry entry;
+      entry.cnf = cnf;
+      entry.Rmap = Rmap;
+      entry.num_primitive_vars = num_primitive_vars;
+      entry.used_tseitin = used_tseitin;
+      entry.simplified = simplify_formula;
+      if (save_cnf_cache(cnf_cache_path, input_hash, entry)) {
+        logger.log(1) << std::endl << "Saved the CNF to " << cnf_cache_path << std::endl;
+      } else {
+        logger.log(0) << std::endl << "Could not write the CNF cache " << cnf_cache_path << std::endl;
+      }
+    }
   }
 
   logger.log(2) << std::endl << "Internal variable mapping:" << std::endl;
@@ -123,22 +558,181 @@ int main(int argc, char **argv) {
 
   logger.log(1) << std::endl << "Final CNF:" << std::endl << *cnf << std::endl;
 
+  /******************
+   * MODEL COUNTING *
+   ******************/
+  if (count_mode) {
+    // every variable past the primitive ones is a Tseitin auxiliary
+    count_opts.aux_defined = true;
+    count_stats stats;
+    bigcount num_models = count_models(cnf, Rmap->size(), num_primitive_vars,
+                                       count_opts, stats, logger.log(2));
+    logger.log(0) << std::endl << "Model count: " << num_models << std::endl;
+    return 0;
+  }
+
+  /*****************
+   * ALL-SOLUTIONS *
+   *****************/
+  if (enumerate_mode) {
+    logger.log(0) << std::endl;
+    uint64_t num_reported = 0;
+    uint64_t num_models = dpll_enumerate(cnf, Rmap->size(), num_primitive_vars, enumerate_limit,
+      [&](assignment &model) {
+        logger.log(0) << "Model " << ++num_reported << ":" << std::endl;
+        print_assignment(model, Rmap, num_primitive_vars);
+        std::cout << std::flush;
+        return true;
+      }, logger.log(2));
+
+    logger.log(0) << std::endl << num_models << " model(s)";
+    if (enumerate_limit && num_models == enumerate_limit) logger.log(0) << " (limit reached)";
+    logger.log(0) << std::endl;
+    return 0;
+  }
+
   /************
    * DPLL SAT *
    ************/
   assignment result;
+  solve_result res;
+  dpll_stats stats;
+  bool has_stats = false;
+  // the binary clauses split off cnf for the plain DPLL search
+  std::vector<std::pair<lit, lit> > binaries;
 
-  logger.log(2) << std::endl << "Running DPLL with " << Rmap->size()
-            << " variables and "<< cnf->clauses.size()
-            << " clauses..." << std::endl;
-  bool is_sat = dpll_sat(cnf, Rmap->size(), result, logger.log(2));
-
-  if (is_sat) {
-    logger.log(0) << std::endl << "SAT" << std::endl;
-    print_assignment(result, Rmap, num_primitive_vars);
+  auto solve_start = std::chrono::steady_clock::now();
+  if (use_local_search) {
+    logger.log(2) << std::endl << "Running local search with " << Rmap->size()
+              << " variables and "<< cnf->clauses.size()
+              << " clauses..." << std::endl;
+    res = ls_sat(cnf, Rmap->size(), ls_opts, result, logger.log(2));
+  } else if (split_into_components) {
+    logger.log(2) << std::endl << "Running DPLL per component with " << Rmap->size()
+              << " variables and "<< cnf->clauses.size()
+              << " clauses..." << std::endl;
+    std::ostream *trace = logger.enabled(2) ? &logger.log(2) : nullptr;
+    res = dpll_sat_components(cnf, Rmap->size(), num_threads, dpll_opts, stats, result, trace);
+    has_stats = true;
   } else {
-    logger.log(0) << std::endl << "NON-SAT" << std::endl;
+    logger.log(2) << std::endl << "Running DPLL with " << Rmap->size()
+              << " variables and "<< cnf->clauses.size()
+              << " clauses..." << std::endl;
+    // the binaries live on in the implication graph only, their clause
+    // objects are freed before the search
+    if (dpll_opts.use_binary_graph) split_binaries(cnf, binaries);
+    if (progress_interval > 0) {
+      res = solve_with_progress(cnf, binaries, Rmap->size(), dpll_opts, progress_interval, stats,
+                                result);
+    } else {
+      res = dpll_solve(cnf, binaries, Rmap->size(), dpll_opts, stats, result, logger.log(2));
+    }
+    has_stats = true;
+  }
+  auto solve_end = std::chrono::steady_clock::now();
+  bool is_sat = res == rsat;
+
+  switch (res) {
+    case rsat:
+      logger.log(0) << std::endl << "SAT" << std::endl;
+      print_assignment(result, Rmap, num_primitive_vars);
+      break;
+    case runsat:
+      logger.log(0) << std::endl << "NON-SAT" << std::endl;
+      break;
+    case runknown:
+      logger.log(0) << std::endl << "UNKNOWN" << std::endl;
+      if (has_stats) logger.log(1) << "Stopped by the " << limit_name(stats.stopped_by) << std::endl;
+      break;
+  }
+
+  if (has_stats) {
+    log_search_stats(logger, stats);
+    if (!dpll_opts.checkpoint_path.empty()) {
+      logger.log(1) << "Checkpoint: " << stats.checkpoints << " snapshot(s) written to "
+                    << dpll_opts.checkpoint_path;
+      if (stats.checkpoint_failures) logger.log(1) << ", " << stats.checkpoint_failures << " failed";
+      logger.log(1) << std::endl;
+    }
+    if (!dpll_opts.resume_path.empty() && !stats.resumed) {
+      // taken on another CNF or with other options, or split into components
+      logger.log(0) << "The snapshot " << dpll_opts.resume_path
+                    << " does not fit this solve, solved from the start" << std::endl;
+    }
+    if (dpll_opts.use_symmetry) {
+      const symmetry_stats &sym = stats.symmetry;
+      logger.log(1) << "Symmetry: " << sym.generators << " generators, " << sym.clauses
+                    << " lex-leader clauses, " << sym.aux_vars << " auxiliary variables, "
+                    << sym.seconds << " s";
+      if (sym.stopped_early) logger.log(1) << " (stopped early)";
+      logger.log(1) << std::endl;
+    }
+  }
+
+  /****************
+   * VERIFICATION *
+   ****************/
+  if (verify_model && is_sat) {
+    auto verify_start = std::chrono::steady_clock::now();
+    Clause *failed = verify_cnf(cnf, result, num_threads);
+    size_t failed_binary = verify_binaries(binaries, result);
+    // a cached CNF comes without its formula
+    bool formula_ok = !(used_tseitin || simplified) || !pr || verify_formula(pr->f, result);
+    auto verify_end = std::chrono::steady_clock::now();
+
+    if (failed) {
+      logger.log(0) << std::endl << "VERIFICATION FAILED: model falsifies clause "
+                    << *failed << std::endl;
+      return 1;
+    }
+    if (failed_binary < binaries.size()) {
+      Clause C;
+      C.literals.push_back(binaries[failed_binary].first);
+      C.literals.push_back(binaries[failed_binary].second);
+      logger.log(0) << std::endl << "VERIFICATION FAILED: model falsifies clause " << C << std::endl;
+      return 1;
+    }
+    if (!formula_ok) {
+      logger.log(0) << std::endl << "VERIFICATION FAILED: model falsifies the input formula"
+                    << std::endl;
+      return 1;
+    }
+
+    std::chrono::duration<double, std::milli> solve_ms = solve_end - solve_start;
+    std::chrono::duration<double, std::milli> verify_ms = verify_end - verify_start;
+    logger.log(1) << std::endl << "Model verified against the CNF";
+    if ((used_tseitin || simplified) && pr) logger.log(1) << " and the input formula";
+    logger.log(1) << std::endl;
+    logger.log(2) << "Solve time: " << solve_ms.count() << " ms, verify time: "
+                  << verify_ms.count() << " ms" << std::endl;
   }
 
   return 0;
-}
\ No newline at end of file
+}
+
+struct main_args {
+  int argc;
+  char **argv;
+  int status;
+};
+
+void *run_sat_main(void *p) {
+  main_args *args = static_cast<main_args *>(p);
+  args->status = sat_main(args->argc, args->argv);
+  return nullptr;
+}
+
+int main(int argc, char **argv) {
+  main_args args = {argc, argv, 0};
+  pthread_attr_t attr;
+  pthread_t thread;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, MAIN_STACK_SIZE);
+  if (pthread_create(&thread, &attr, run_sat_main, &args) != 0) {
+    // fall back to the normal stack
+    return sat_main(argc, argv);
+  }
+  pthread_join(thread, nullptr);
+  pthread_attr_destroy(&attr);
+  return args.status;
+}
@@ -2,10 +2,16 @@
 #include <stack>
 #include <utility>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
 
 #include "formula.h"
 #include "parser.h"
 
+// the variable table starts with 2^VAR_TABLE_INITIAL_BITS slots
+#define VAR_TABLE_INITIAL_BITS 10
+
 /* for recording states in the parent_stack */
 struct record {
   Formula **fp;
@@ -23,29 +29,157 @@ bool is_var_char(char *f) {
          (*f >= '0' && *f <= '9');
 }
 
-// return last position of variable name
-char *parse_var(char *f, vmap_t *Vmap, rmap_t *Rmap, Variable **ret_var) {
-  int len = 0;
-  while (is_var_char(f)) {
-    f++;
-    len++;
+// whitespace between tokens
+bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// FNV-1a
+uint64_t hash_name(const char *name, size_t len) {
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t i = 0; i < len; i++) {
+    h ^= static_cast<unsigned char>(name[i]);
+    h *= 1099511628211ULL;
   }
+  return h;
+}
+
+// Interns variable names while parsing. Names are looked up as views into
+// the input buffer in an open addressing table: one hash and one probe
+// sequence per occurrence, and nothing is allocated for a name seen before.
+// Each variable gets a single Variable node that all its occurrences share.
+class var_table {
+  std::vector<const char *> name_data;
+  std::vector<size_t> name_len;
+  std::vector<uint64_t> name_hash;
+  std::vector<int> slots;   // variable in each slot, -1 if empty
+  int slot_bits;
+
+  // fibonacci hashing spreads the weak low bits of FNV-1a on short names
+  size_t home_slot(uint64_t h) const {
+    return (h * 11400714819323198485ULL) >> (64 - slot_bits);
+  }
+
+  void grow() {
+    slot_bits++;
+    std::vector<int> old_slots(static_cast<size_t>(1) << slot_bits, -1);
+    old_slots.swap(slots);
+    size_t mask = slots.size() - 1;
+    for (size_t v = 0; v < name_hash.size(); v++) {
+      size_t i = home_slot(name_hash[v]);
+      while (slots[i] >= 0) i = (i + 1) & mask;
+      slots[i] = v;
+    }
+  }
+
+public:
+  std::vector<Variable *> nodes;
 
-  std::string var_name(f-len, len);
-  auto var_int = Vmap->find(var_name);
-  if (var_int == Vmap->end()) {
-    // new var
-    (*Vmap)[var_name] = Rmap->size();
-    Rmap->push_back(var_name);
+  var_table() : slots(static_cast<size_t>(1) << VAR_TABLE_INITIAL_BITS, -1),
+    slot_bits(VAR_TABLE_INITIAL_BITS) {}
+
+  Variable *intern(const char *name, size_t len) {
+    uint64_t h = hash_name(name, len);
+    size_t mask = slots.size() - 1;
+    size_t i = home_slot(h);
+    for (; slots[i] >= 0; i = (i + 1) & mask) {
+      int v = slots[i];
+      if (name_hash[v] == h && name_len[v] == len && std::memcmp(name_data[v], name, len) == 0) {
+        return nodes[v];
+      }
+    }
+
+    int v = nodes.size();
+    slots[i] = v;
+    name_data.push_back(name);
+    name_len.push_back(len);
+    name_hash.push_back(h);
+    nodes.push_back(new Variable(v, std::string(name, len)));
+    // keep the load factor at most 1/2
+    if (2 * nodes.size() > slots.size()) grow();
+    return nodes.back();
   }
+};
+
+// return last position of variable name
+char *parse_var(char *f, var_table &vars, Variable **ret_var) {
+  char *start = f;
+  while (is_var_char(f)) f++;
 
-  *ret_var = new Variable((*Vmap)[var_name], var_name);
+  *ret_var = vars.intern(start, f - start);
   return f - 1;
 }
 
+// whether f starts a cardinality constraint, i.e. one of the keywords
+// directly followed by '(' (a variable is never followed by '(')
+bool match_cardinality(char *f, char *end, CardinalityBound *bound, char **paren) {
+  static const CardinalityBound bounds[] = {atmost, atleast, exactly};
+  for (CardinalityBound b : bounds) {
+    const char *kw = Cardinality::keyword(b);
+    size_t len = strlen(kw);
+    if (static_cast<size_t>(end - f) <= len || strncmp(f, kw, len) != 0) continue;
+
+    char *p = f + len;
+    while (p < end && is_space(*p)) p++;
+    if (p < end && *p == '(') {
+      *bound = b;
+      *paren = p;
+      return true;
+    }
+  }
+  return false;
+}
+
+// parse "(k, l1, ..., ln)" where every operand li is a possibly negated
+// variable; return the position of the closing paren, or 0 with *error set
+char *parse_cardinality(char *f, char *end, var_table &vars,
+                        Cardinality *card, parse_result **error) {
+  f++;
+  while (f < end && is_space(*f)) f++;
+  if (f >= end || *f < '0' || *f > '9') {
+    *error = new parse_result(f, 'n');
+    return 0;
+  }
+  long k = 0;
+  while (f < end && *f >= '0' && *f <= '9') {
+    k = k * 10 + (*f - '0');
+    if (k > 1000000000) {
+      *error = new parse_result(f, 'n');
+      return 0;
+    }
+    f++;
+  }
+  card->k = k;
+
+  while (true) {
+    while (f < end && is_space(*f)) f++;
+    if (f < end && *f == ')' && !card->operands.empty()) return f;
+    if (f >= end || *f != ',') {
+      *error = new parse_result(f, card->operands.empty() ? ',' : ')');
+      return 0;
+    }
+    f++;
+
+    int negations = 0;
+    while (f < end && (is_space(*f) || *f == '!')) {
+      if (*f == '!') negations++;
+      f++;
+    }
+    if (f >= end || !is_var_char(f)) {
+      *error = new parse_result(f, 'e');
+      return 0;
+    }
+
+    Variable *v;
+    f = parse_var(f, vars, &v) + 1;
+    Formula *operand = v;
+    for (int i = 0; i < negations; i++) operand = new Negated(operand);
+    card->operands.push_back(operand);
+  }
+}
+
 parse_result *parse_formula(char *f, char *end) {
-  vmap_t *Vmap = new vmap_t;
-  rmap_t *Rmap = new rmap_t;
+  var_table vars;
 
   int depth = 0;
   bool expect_expr = true;
@@ -55,11 +189,18 @@ parse_result *parse_formula(char *f, char *end) {
 
   // kick start
   Formula *root = 0;
+
+  // drop the partial parse on errors
+  auto fail = [&](char *pos, char exp) {
+    Formula::release(root);
+    for (auto it = vars.nodes.begin(); it != vars.nodes.end(); it++) delete *it;
+    return new parse_result(pos, exp);
+  };
   parent_stack.emplace(&root, 0);
   parent_stack.emplace(&root, 0);
 
   while(f < end && *f) {
-    if (*f == ' ') {
+    if (is_space(*f)) {
       // skip whitespace between tokens
       f++;
       continue;
@@ -82,11 +223,28 @@ parse_result *parse_formula(char *f, char *end) {
           break;
         default:
           // allow a-z A-z 0-9
-          if (!is_var_char(f)) return new parse_result(f, 'e');
+          if (!is_var_char(f)) return fail(f, 'e');
 
           {
-            Variable *new_one;
-            f = parse_var(f, Vmap, Rmap, &new_one);
+            Formula *new_one;
+            CardinalityBound bound;
+            char *paren;
+            if (match_cardinality(f, end, &bound, &paren)) {
+              Cardinality *card = new Cardinality(bound, 0);
+              parse_result *error = 0;
+              f = parse_cardinality(paren, end, vars, card, &error);
+              if (!f) {
+                delete card;
+                parse_result *res = fail(error->error_char_pos, error->expects);
+                delete error;
+                return res;
+              }
+              new_one = card;
+            } else {
+              Variable *v;
+              f = parse_var(f, vars, &v);
+              new_one = v;
+            }
 
             assert(parent_stack.size() >= 1);
             record curr_record = parent_stack.top();
@@ -107,7 +265,7 @@ parse_result *parse_formula(char *f, char *end) {
       // expecting a connective
       if (*f == ')') {
         depth--;
-        if (depth < 0) return new parse_result(f-1, '(');
+        if (depth < 0) return fail(f-1, '(');
 
         // move back up
         record curr_record = parent_stack.top();
@@ -127,19 +285,19 @@ parse_result *parse_formula(char *f, char *end) {
             break;
           case '<':
             // start of equiv
-            if (f[1] != '-') return new parse_result(f+1, '-');
-            if (f[2] != '>') return new parse_result(f+2, '>');
+            if (f[1] != '-') return fail(f+1, '-');
+            if (f[2] != '>') return fail(f+2, '>');
             bin_op = lequiv;
             f += 2; // bring f to last char of connective
             break;
           case '-':
             // start of imply
-            if (f[1] != '>') return new parse_result(f+1, '>');
+            if (f[1] != '>') return fail(f+1, '>');
             bin_op = limply;
             f += 1; // bring f to last char of connective
             break;
           default:
-            return new parse_result(f, 'c');
+            return fail(f, 'c');
         }
         expect_expr = true; // we now expect an expression
 
@@ -155,12 +313,34 @@ parse_result *parse_formula(char *f, char *end) {
     f++;
   }
 
-  if (depth != 0) return new parse_result(f, ')');
+  if (depth != 0) return fail(f, ')');
+  if (expect_expr) return fail(f, 'e');
+
+  vmap_t *Vmap = new vmap_t;
+  rmap_t *Rmap = new rmap_t;
+  Vmap->reserve(vars.nodes.size());
+  Rmap->reserve(vars.nodes.size());
+  for (auto it = vars.nodes.begin(); it != vars.nodes.end(); it++) {
+    (*Vmap)[(*it)->name] = (*it)->var;
+    Rmap->push_back((*it)->name);
+  }
 
-  return new parse_result(root, Vmap, Rmap);
+  parse_result *res = new parse_result(root, Vmap, Rmap);
+  res->variables.swap(vars.nodes);
+  return res;
 }
 
 /* helpers */
+void free_parse_result(parse_result *pr) {
+  if (!pr->has_error()) {
+    Formula::release(pr->f);
+    for (auto it = pr->variables.begin(); it != pr->variables.end(); it++) delete *it;
+    delete pr->Vmap;
+    delete pr->Rmap;
+  }
+  delete pr;
+}
+
 void print_rmap(rmap_t *Rmap, std::ostream &output) {
   for (int i = 0; i < Rmap->size(); i++) {
     output << i << ": " << (*Rmap)[i] << std::endl;
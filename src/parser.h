@@ -15,6 +15,8 @@ struct parse_result {
   Formula *f;
   vmap_t *Vmap;
   rmap_t *Rmap;
+  // the single node of every variable, shared by all its occurrences
+  std::vector<Variable *> variables;
 
   char *error_char_pos;
   char expects;
@@ -31,6 +33,9 @@ struct parse_result {
 
 void print_rmap(rmap_t *Rmap, std::ostream &output);
 
+// frees pr together with the formula and variable maps it holds
+void free_parse_result(parse_result *pr);
+
 parse_result *parse_formula(char *f, char *end);
 
 #endif /* PARSER_H */
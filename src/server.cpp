@@ -0,0 +1,345 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "cnf.h"
+#include "implication.h"
+#include "parser.h"
+#include "server.h"
+#include "tseitin.h"
+
+// rough per-entry bookkeeping cost of the cache on top of key and model
+#define RESULT_ENTRY_OVERHEAD 96
+
+// A CNF up to clause order and variable renaming: variables are ordered by
+// name, literals sorted and deduplicated within each clause and the clauses
+// sorted and deduplicated, then variables are renumbered in order of first
+// occurrence in the sorted clauses and both sorts are redone under the new
+// numbers. The clauses are
+// flattened with UINT32_MAX closing every clause.
+struct canonical_cnf {
+  std::vector<uint32_t> key;
+  std::vector<var> query_var;   // canonical variable -> variable of the request
+};
+
+void canonicalize(CNF *cnf, int num_vars, const rmap_t &names, int num_primitive_vars,
+                  canonical_cnf &canon) {
+  // the parser numbers variables by first occurrence, which depends on the
+  // clause order, so the first sort goes by name; Tseitin variables have no
+  // name of their own and keep their order after the named ones
+  std::vector<var> by_name(num_vars);
+  for (var v = 0; v < num_vars; v++) by_name[v] = v;
+  std::sort(by_name.begin(), by_name.begin() + num_primitive_vars,
+            [&](var a, var b) { return names[a] < names[b]; });
+  std::vector<var> rank(num_vars);
+  for (var r = 0; r < num_vars; r++) rank[by_name[r]] = r;
+
+  std::vector<std::vector<lit> > clauses;
+  clauses.reserve(cnf->clauses.size());
+  for (auto C = cnf->clauses.begin(); C != cnf->clauses.end(); C++) {
+    std::vector<lit> clause;
+    for (auto L = (*C)->literals.begin(); L != (*C)->literals.end(); L++) {
+      clause.push_back(mk_lit(rank[lit_var(*L)], lit_is_pos(*L)));
+    }
+    std::sort(clause.begin(), clause.end());
+    clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
+    clauses.push_back(clause);
+  }
+  std::sort(clauses.begin(), clauses.end());
+  clauses.erase(std::unique(clauses.begin(), clauses.end()), clauses.end());
+
+  std::vector<var> canon_var(num_vars, -1);
+  for (auto C = clauses.begin(); C != clauses.end(); C++) {
+    for (auto L = C->begin(); L != C->end(); L++) {
+      var v = lit_var(*L);
+      if (canon_var[v] < 0) {
+        canon_var[v] = canon.query_var.size();
+        canon.query_var.push_back(by_name[v]);
+      }
+      *L = mk_lit(canon_var[v], lit_is_pos(*L));
+    }
+    std::sort(C->begin(), C->end());
+  }
+  // renaming is one-to-one, no duplicates can appear
+  std::sort(clauses.begin(), clauses.end());
+
+  for (auto C = clauses.begin(); C != clauses.end(); C++) {
+    canon.key.insert(canon.key.end(), C->begin(), C->end());
+    canon.key.push_back(UINT32_MAX);
+  }
+}
+
+struct canonical_key_hash {
+  size_t operator()(const std::vector<uint32_t> &key) const {
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (auto it = key.begin(); it != key.end(); it++) {
+      h ^= *it;
+      h *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(h);
+  }
+};
+
+struct cached_result {
+  solve_result res;
+  std::vector<bool> model;   // over the canonical variables
+};
+
+// result cache shared by all workers, least-recently-used eviction under a
+// byte budget
+class result_cache {
+  struct entry {
+    cached_result result;
+    std::list<const std::vector<uint32_t> *>::iterator lru_pos;
+  };
+
+  std::unordered_map<std::vector<uint32_t>, entry, canonical_key_hash> entries;
+  std::list<const std::vector<uint32_t> *> lru; // most recently used first
+  size_t max_bytes;
+  size_t bytes;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  std::mutex lock;
+
+  static size_t entry_bytes(const std::vector<uint32_t> &key, const cached_result &result) {
+    return key.size() * sizeof(uint32_t) + result.model.size() / 8 + RESULT_ENTRY_OVERHEAD;
+  }
+
+public:
+  result_cache(size_t max_b) : max_bytes(max_b), bytes(0), hits(0), misses(0), evictions(0) {}
+
+  bool lookup(const std::vector<uint32_t> &key, cached_result &result) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+      misses++;
+      return false;
+    }
+    hits++;
+    lru.splice(lru.begin(), lru, it->second.lru_pos);
+    result = it->second.result;
+    return true;
+  }
+
+  void store(const std::vector<uint32_t> &key, const cached_result &result) {
+    size_t size = entry_bytes(key, result);
+    std::lock_guard<std::mutex> guard(lock);
+    if (size > max_bytes) return;
+
+    while (bytes + size > max_bytes && !lru.empty()) {
+      auto victim = entries.find(*lru.back());
+      bytes -= entry_bytes(victim->first, victim->second.result);
+      lru.pop_back();
+      entries.erase(victim);
+      evictions++;
+    }
+
+    auto res = entries.emplace(key, entry());
+    if (!res.second) return;
+    res.first->second.result = result;
+    lru.push_front(&res.first->first);
+    res.first->second.lru_pos = lru.begin();
+    bytes += size;
+  }
+
+  std::string stats_line() {
+    std::lock_guard<std::mutex> guard(lock);
+    uint64_t lookups = hits + misses;
+    std::ostringstream oss;
+    oss << "#stats lookups=" << lookups << " hits=" << hits << " misses=" << misses
+        << " hit_rate=" << (lookups ? 100.0 * hits / lookups : 0.0) << "%"
+        << " entries=" << entries.size() << " bytes=" << bytes << " evictions=" << evictions;
+    return oss.str();
+  }
+};
+
+// Per-thread state of one worker: its input buffer and the stream the
+// solver trace goes to. Every request builds and solves its CNF from
+// scratch, workers only share the result cache.
+class server_worker {
+  const server_options &opts;
+  result_cache &cache;
+  null_buffer nb;
+  std::ostream null_stream;
+  std::vector<char> input;
+
+public:
+  server_worker(const server_options &o, result_cache &c) :
+    opts(o), cache(c), nb(), null_stream(&nb) {}
+
+  std::string handle(const std::string &line) {
+    if (line.compare(0, 6, "#stats") == 0) return cache.stats_line();
+
+    auto start = std::chrono::steady_clock::now();
+    std::ostringstream out;
+
+    input.assign(line.begin(), line.end());
+    input.push_back('\0');
+    parse_result *pr = parse_formula(input.data(), input.data() + line.size());
+    if (pr->has_error()) {
+      out << "ERROR " << (pr->error_char_pos - input.data()) << " " << pr->expects;
+      free_parse_result(pr);
+      return out.str();
+    }
+
+    tseitin_init(pr->Vmap, pr->Rmap);
+    int num_primitive_vars = pr->Rmap->size();
+    CNF *cnf = parse_into_cnf(pr->f);
+    if (!cnf) cnf = tseitin_transform(pr->f);
+    int num_vars = pr->Rmap->size();
+
+    canonical_cnf canon;
+    canonicalize(cnf, num_vars, *pr->Rmap, num_primitive_vars, canon);
+
+    cached_result cached;
+    assignment model;
+    limit_kind stopped_by = no_limit;
+    bool hit = cache.lookup(canon.key, cached);
+    if (hit) {
+      // variables without clauses default to true, as in dpll_sat
+      model.assign(num_vars, true);
+      for (size_t i = 0; i < cached.model.size(); i++) model[canon.query_var[i]] = cached.model[i];
+    } else {
+      dpll_stats stats;
+      std::vector<std::pair<lit, lit> > binaries;
+      if (opts.solver.use_binary_graph) split_binaries(cnf, binaries);
+      cached.res = dpll_solve(cnf, binaries, num_vars, opts.solver, stats, model, null_stream);
+      stopped_by = stats.stopped_by;
+      if (cached.res == rsat) {
+        cached.model.resize(canon.query_var.size());
+        for (size_t i = 0; i < cached.model.size(); i++) cached.model[i] = model[canon.query_var[i]];
+      }
+      if (cached.res != runknown) cache.store(canon.key, cached);
+    }
+
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    switch (cached.res) {
+      case rsat:
+        out << "SAT";
+        break;
+      case runsat:
+        out << "NON-SAT";
+        break;
+      case runknown:
+        out << "UNKNOWN";
+        break;
+    }
+    out << " " << (hit ? "hit" : "miss") << " " << static_cast<uint64_t>(elapsed.count());
+    if (cached.res == runknown) out << " " << limit_name(stopped_by);
+    if (cached.res == rsat) {
+      for (int v = 0; v < num_primitive_vars; v++) {
+        out << " " << (*pr->Rmap)[v] << "=" << (model[v] ? 1 : 0);
+      }
+    }
+
+    free_cnf(cnf);
+    free_parse_result(pr);
+    return out.str();
+  }
+};
+
+bool send_all(int fd, const std::string &data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    sent += n;
+  }
+  return true;
+}
+
+// answer newline-separated requests until the client hangs up
+void serve_connection(int fd, server_worker &worker) {
+  std::string pending;
+  char buf[4096];
+  while (true) {
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n <= 0) return;
+    pending.append(buf, n);
+
+    size_t start = 0;
+    size_t newline;
+    while ((newline = pending.find('\n', start)) != std::string::npos) {
+      std::string line = pending.substr(start, newline - start);
+      start = newline + 1;
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      if (line.empty()) continue;
+      if (!send_all(fd, worker.handle(line) + "\n")) return;
+    }
+    pending.erase(0, start);
+  }
+}
+
+int run_socket_server(const server_options &opts, result_cache &cache) {
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (opts.socket_path.size() >= sizeof(addr.sun_path)) {
+    std::cerr << "Socket path too long: " << opts.socket_path << std::endl;
+    return 1;
+  }
+  std::strcpy(addr.sun_path, opts.socket_path.c_str());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    std::cerr << "Cannot create socket: " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+  unlink(addr.sun_path);
+  if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+      listen(fd, SOMAXCONN) != 0) {
+    std::cerr << "Cannot listen on " << opts.socket_path << ": " << std::strerror(errno) << std::endl;
+    close(fd);
+    return 1;
+  }
+  std::cerr << "Listening on " << opts.socket_path << std::endl;
+
+  auto worker = [&]() {
+    server_worker context(opts, cache);
+    while (true) {
+      int conn = accept(fd, nullptr, nullptr);
+      if (conn < 0) {
+        if (errno == EINTR || errno == ECONNABORTED) continue;
+        return;
+      }
+      serve_connection(conn, context);
+      close(conn);
+    }
+  };
+
+  int num_threads = std::max(opts.num_threads, 1);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < num_threads; t++) workers.emplace_back(worker);
+  for (auto it = workers.begin(); it != workers.end(); it++) it->join();
+
+  close(fd);
+  return 0;
+}
+
+int run_server(const server_options &opts) {
+  result_cache cache(opts.cache_bytes);
+  if (!opts.socket_path.empty()) return run_socket_server(opts, cache);
+
+  server_worker worker(opts, cache);
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty()) continue;
+    std::cout << worker.handle(line) << std::endl;
+  }
+  std::cerr << cache.stats_line() << std::endl;
+  return 0;
+}
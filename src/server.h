@@ -0,0 +1,39 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <cstddef>
+#include <string>
+
+#include "dpll.h"
+
+struct server_options {
+  // listen on this unix domain socket, or serve stdin/stdout if empty
+  std::string socket_path;
+  // worker threads for socket connections
+  int num_threads;
+  // memory bound for the result cache, least recently used entries go first
+  size_t cache_bytes;
+  dpll_options solver;
+
+  server_options() : num_threads(1), cache_bytes(64 << 20) {}
+};
+
+// Long-running solve server. Every request is one formula per line and
+// gets one line back:
+//
+//   SAT <hit|miss> <microseconds> name=0|1 ...
+//   NON-SAT <hit|miss> <microseconds>
+//   UNKNOWN <hit|miss> <microseconds> <limit>
+//   ERROR <position> <expected>
+//
+// Results are cached by the canonical form of the request's CNF, so a
+// repeated formula, also one with renamed variables, is answered without
+// searching. Limited (UNKNOWN) results are not cached. The line "#stats"
+// is answered with the cache statistics instead.
+//
+// On stdin the server stops at end of input and reports the statistics on
+// stderr; on a socket it serves connections until killed. Returns the exit
+// status.
+int run_server(const server_options &opts);
+
+#endif /* SERVER_H */
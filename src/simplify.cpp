@@ -0,0 +1,413 @@
+#include <algorithm>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "simplify.h"
+
+// ids of the constants, every other id is a node
+#define FALSE_ID 0
+#define TRUE_ID 1
+
+// a chain that simplified into an operand of the same operator is only
+// spliced into its parent up to this many operands, so that nesting such
+// chains cannot make the pass quadratic
+#define SIMPLIFY_MAX_SPLICE 64
+
+// below this many operands, a chain is searched instead of hashed
+#define SIMPLIFY_SMALL_CHAIN 16
+
+// initial size of the node table, a power of two
+#define SIMPLIFY_INITIAL_SLOTS 1024
+
+// A node of the simplified formula. Nodes are hash-consed, so equal
+// subformulas have equal ids. & and | are n-ary with their operands in
+// input order.
+struct snode {
+  Formula::Type type;
+  int op;                     // Connective or CardinalityBound
+  int k;
+  Variable *v;
+  std::vector<int> operands;
+};
+
+// operand ids of a chain, searched linearly while the chain is short
+class id_set {
+  std::vector<int> small;
+  std::unordered_set<int> large;
+
+public:
+  bool contains(int id) const {
+    if (large.empty()) return std::find(small.begin(), small.end(), id) != small.end();
+    return large.count(id) > 0;
+  }
+
+  void insert(int id) {
+    if (!large.empty()) {
+      large.insert(id);
+      return;
+    }
+    small.push_back(id);
+    if (small.size() > SIMPLIFY_SMALL_CHAIN) large.insert(small.begin(), small.end());
+  }
+};
+
+class simplifier {
+  std::vector<snode> nodes;
+  std::vector<uint64_t> hashes;
+  // open-addressing table of node ids by hash, -1 if empty
+  std::vector<int> slots;
+  size_t slot_mask;
+
+  static bool commutative(const snode &n) {
+    return n.type == Formula::binary && n.op != limply;
+  }
+
+  // operands in a canonical order, so that a & b and b & a are one node
+  static std::vector<int> canonical_operands(const snode &n) {
+    std::vector<int> ops = n.operands;
+    if (commutative(n)) std::sort(ops.begin(), ops.end());
+    return ops;
+  }
+
+  static uint64_t hash_of(const snode &n) {
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h](int x) {
+      h ^= static_cast<uint32_t>(x);
+      h *= 1099511628211ULL;
+    };
+    mix(n.type);
+    mix(n.op);
+    mix(n.k);
+    mix(n.v ? n.v->var : -1);
+    if (commutative(n) && n.operands.size() > 2) {
+      std::vector<int> ops = canonical_operands(n);
+      for (auto it = ops.begin(); it != ops.end(); it++) mix(*it);
+    } else if (commutative(n)) {
+      mix(std::min(n.operands[0], n.operands[1]));
+      mix(std::max(n.operands[0], n.operands[1]));
+    } else {
+      for (auto it = n.operands.begin(); it != n.operands.end(); it++) mix(*it);
+    }
+    return h;
+  }
+
+  static bool same(const snode &a, const snode &b) {
+    if (a.type != b.type || a.op != b.op || a.k != b.k || a.v != b.v ||
+        a.operands.size() != b.operands.size()) {
+      return false;
+    }
+    if (!commutative(a)) return a.operands == b.operands;
+    if (a.operands.size() == 2) {
+      return std::min(a.operands[0], a.operands[1]) == std::min(b.operands[0], b.operands[1]) &&
+             std::max(a.operands[0], a.operands[1]) == std::max(b.operands[0], b.operands[1]);
+    }
+    return canonical_operands(a) == canonical_operands(b);
+  }
+
+  // slot holding the node equal to n, or the empty slot where it belongs
+  size_t find_slot(const snode &n, uint64_t h) const {
+    size_t i = (h * 11400714819323198485ULL) >> 32 & slot_mask;
+    while (slots[i] >= 0 && !(hashes[slots[i]] == h && same(nodes[slots[i]], n))) {
+      i = (i + 1) & slot_mask;
+    }
+    return i;
+  }
+
+  void grow() {
+    std::vector<int> old_slots(slots.size() * 2, -1);
+    old_slots.swap(slots);
+    slot_mask = slots.size() - 1;
+    for (auto it = old_slots.begin(); it != old_slots.end(); it++) {
+      if (*it < 0) continue;
+      size_t i = (hashes[*it] * 11400714819323198485ULL) >> 32 & slot_mask;
+      while (slots[i] >= 0) i = (i + 1) & slot_mask;
+      slots[i] = *it;
+    }
+  }
+
+  int intern(const snode &n) {
+    uint64_t h = hash_of(n);
+    size_t i = find_slot(n, h);
+    if (slots[i] >= 0) return slots[i];
+    slots[i] = nodes.size();
+    nodes.push_back(n);
+    hashes.push_back(h);
+    if (2 * nodes.size() > slots.size()) grow();
+    return nodes.size() - 1;
+  }
+
+  bool is_chain(int id, Connective op) const {
+    return id > TRUE_ID && nodes[id].type == Formula::binary && nodes[id].op == op &&
+           (op == land || op == lor);
+  }
+
+  int negate(int id) {
+    if (id <= TRUE_ID) return TRUE_ID - id;
+    if (nodes[id].type == Formula::negated) {
+      stats.double_negations++;
+      return nodes[id].operands[0];
+    }
+    snode n = {Formula::negated, 0, 0, nullptr, std::vector<int>(1, id)};
+    return intern(n);
+  }
+
+  // id of !id if that node exists, -1 otherwise
+  int complement_of(int id) const {
+    if (id <= TRUE_ID) return TRUE_ID - id;
+    if (nodes[id].type == Formula::negated) return nodes[id].operands[0];
+    snode n = {Formula::negated, 0, 0, nullptr, std::vector<int>(1, id)};
+    return slots[find_slot(n, hash_of(n))];
+  }
+
+  int chain(Connective op, const std::vector<int> &operands) {
+    // a & false = false, a & true = a, and the other way round for |
+    int absorbing = op == land ? FALSE_ID : TRUE_ID;
+    int neutral = TRUE_ID - absorbing;
+    Connective dual = op == land ? lor : land;
+
+    std::vector<int> list;
+    id_set seen;
+    bool folded = false;
+    auto add = [&](int id) {
+      if (seen.contains(id)) {
+        stats.duplicates++;
+        return;
+      }
+      int c = complement_of(id);
+      if (c >= 0 && seen.contains(c)) {
+        stats.complements++;
+        folded = true;
+        return;
+      }
+      seen.insert(id);
+      list.push_back(id);
+    };
+
+    for (auto it = operands.begin(); it != operands.end() && !folded; it++) {
+      if (*it == neutral) {
+        stats.constants++;
+      } else if (*it == absorbing) {
+        stats.constants++;
+        return absorbing;
+      } else if (is_chain(*it, op) && nodes[*it].operands.size() <= SIMPLIFY_MAX_SPLICE) {
+        const std::vector<int> &inner = nodes[*it].operands;
+        for (auto in = inner.begin(); in != inner.end() && !folded; in++) add(*in);
+      } else {
+        add(*it);
+      }
+    }
+    if (folded) return absorbing;
+
+    // a & (a | b) = a, a | (a & b) = a
+    std::vector<int> kept;
+    for (auto it = list.begin(); it != list.end(); it++) {
+      bool absorbed = false;
+      if (is_chain(*it, dual)) {
+        const std::vector<int> &inner = nodes[*it].operands;
+        for (auto in = inner.begin(); in != inner.end() && !absorbed; in++) {
+          absorbed = seen.contains(*in);
+        }
+      }
+      if (absorbed) {
+        stats.absorptions++;
+      } else {
+        kept.push_back(*it);
+      }
+    }
+
+    if (kept.empty()) return neutral;
+    if (kept.size() == 1) return kept[0];
+    snode n = {Formula::binary, op, 0, nullptr, kept};
+    return intern(n);
+  }
+
+  int implies(int a, int b) {
+    if (a == FALSE_ID || b == TRUE_ID) {
+      stats.constants++;
+      return TRUE_ID;
+    }
+    if (a == TRUE_ID) {
+      stats.constants++;
+      return b;
+    }
+    if (b == FALSE_ID) {
+      stats.constants++;
+      return negate(a);
+    }
+    if (a == b) {
+      stats.duplicates++;
+      return TRUE_ID;
+    }
+    // a -> !a = !a, !a -> a = a
+    if (complement_of(a) == b) {
+      stats.complements++;
+      return b;
+    }
+    snode n = {Formula::binary, limply, 0, nullptr, {a, b}};
+    return intern(n);
+  }
+
+  int equiv(int a, int b) {
+    if (a <= TRUE_ID) std::swap(a, b);
+    if (b == TRUE_ID) {
+      stats.constants++;
+      return a;
+    }
+    if (b == FALSE_ID) {
+      stats.constants++;
+      return negate(a);
+    }
+    if (a == b) {
+      stats.duplicates++;
+      return TRUE_ID;
+    }
+    if (complement_of(a) == b) {
+      stats.complements++;
+      return FALSE_ID;
+    }
+    if (nodes[a].type == Formula::negated && nodes[b].type == Formula::negated) {
+      stats.double_negations++;
+      a = nodes[a].operands[0];
+      b = nodes[b].operands[0];
+    }
+    snode n = {Formula::binary, lequiv, 0, nullptr, {a, b}};
+    return intern(n);
+  }
+
+  int cardinality(Cardinality *c) {
+    snode n = {Formula::cardinality, c->bound, c->k, nullptr, std::vector<int>()};
+    for (auto it = c->operands.begin(); it != c->operands.end(); it++) {
+      n.operands.push_back(walk(*it));
+    }
+
+    // bounds that hold or fail whatever the operands are
+    int size = n.operands.size();
+    int res = -1;
+    switch (c->bound) {
+      case atmost:
+        if (c->k >= size) res = TRUE_ID;
+        if (c->k < 0) res = FALSE_ID;
+        break;
+      case atleast:
+        if (c->k <= 0) res = TRUE_ID;
+        if (c->k > size) res = FALSE_ID;
+        break;
+      case exactly:
+        if (c->k < 0 || c->k > size) res = FALSE_ID;
+        break;
+    }
+    if (res >= 0) {
+      stats.constants++;
+      return res;
+    }
+    return intern(n);
+  }
+
+public:
+  simplify_stats stats;
+
+  simplifier() : slots(SIMPLIFY_INITIAL_SLOTS, -1), slot_mask(SIMPLIFY_INITIAL_SLOTS - 1) {
+    // the constants take the first two ids and are never looked up
+    snode constant = {Formula::variable, 0, 0, nullptr, std::vector<int>()};
+    nodes.push_back(constant);
+    nodes.push_back(constant);
+    hashes.push_back(0);
+    hashes.push_back(0);
+  }
+
+  int walk(Formula *f) {
+    stats.nodes_before++;
+    switch (f->type) {
+      case Formula::variable:
+        {
+          snode n = {Formula::variable, 0, 0, static_cast<Variable *>(f), std::vector<int>()};
+          return intern(n);
+        }
+      case Formula::negated:
+        return negate(walk(static_cast<Negated *>(f)->f));
+      case Formula::binary:
+        {
+          Binary *b = static_cast<Binary *>(f);
+          if (b->op == limply) return implies(walk(b->l), walk(b->r));
+          if (b->op == lequiv) return equiv(walk(b->l), walk(b->r));
+
+          // the operands of the whole chain, left to right
+          std::vector<int> operands;
+          std::vector<Formula *> stack(1, b->r);
+          Formula *cur = b->l;
+          while (true) {
+            if (cur->type == Formula::binary && static_cast<Binary *>(cur)->op == b->op) {
+              stats.nodes_before++;
+              stack.push_back(static_cast<Binary *>(cur)->r);
+              cur = static_cast<Binary *>(cur)->l;
+              continue;
+            }
+            operands.push_back(walk(cur));
+            if (stack.empty()) break;
+            cur = stack.back();
+            stack.pop_back();
+          }
+          return chain(b->op, operands);
+        }
+      case Formula::cardinality:
+        return cardinality(static_cast<Cardinality *>(f));
+    }
+    return FALSE_ID;
+  }
+
+  Formula *build(int id) {
+    const snode &n = nodes[id];
+    stats.nodes_after++;
+    switch (n.type) {
+      case Formula::variable:
+        return n.v;
+      case Formula::negated:
+        return new Negated(build(n.operands[0]));
+      case Formula::binary:
+        {
+          // chains associate to the left, as the parser does
+          Formula *res = build(n.operands[0]);
+          for (size_t i = 1; i < n.operands.size(); i++) {
+            if (i > 1) stats.nodes_after++;
+            res = new Binary(res, build(n.operands[i]), static_cast<Connective>(n.op));
+          }
+          return res;
+        }
+      case Formula::cardinality:
+        {
+          Cardinality *c = new Cardinality(static_cast<CardinalityBound>(n.op), n.k);
+          for (auto it = n.operands.begin(); it != n.operands.end(); it++) {
+            c->operands.push_back(build(*it));
+          }
+          return c;
+        }
+    }
+    return nullptr;
+  }
+};
+
+simplify_result simplify(Formula *f) {
+  simplifier s;
+  int root = s.walk(f);
+
+  simplify_result res;
+  res.f = root > TRUE_ID ? s.build(root) : nullptr;
+  res.value = root == TRUE_ID;
+  res.stats = s.stats;
+  return res;
+}
+
+CNF *constant_cnf(bool value) {
+  CNF *cnf = new CNF();
+  if (!value) {
+    Clause *pos = new Clause();
+    Clause *neg = new Clause();
+    pos->literals.push_back(mk_lit(0, true));
+    neg->literals.push_back(mk_lit(0, false));
+    cnf->clauses.push_back(pos);
+    cnf->clauses.push_back(neg);
+  }
+  return cnf;
+}
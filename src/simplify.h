@@ -0,0 +1,45 @@
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <cstddef>
+
+#include "cnf.h"
+#include "formula.h"
+
+struct simplify_stats {
+  size_t nodes_before;
+  size_t nodes_after;
+  size_t double_negations;  // !!a -> a, !a <-> !b -> a <-> b
+  size_t duplicates;        // a & a -> a, a <-> a -> true
+  size_t complements;       // a | !a -> true, a & !a -> false
+  size_t constants;         // folded or dropped constants
+  size_t absorptions;       // a & (a | b) -> a
+
+  simplify_stats() : nodes_before(0), nodes_after(0), double_negations(0), duplicates(0),
+    complements(0), constants(0), absorptions(0) {}
+
+  size_t rewrites() const {
+    return double_negations + duplicates + complements + constants + absorptions;
+  }
+};
+
+struct simplify_result {
+  // the simplified formula, or nullptr if the formula is the constant value
+  Formula *f;
+  bool value;
+  simplify_stats stats;
+};
+
+// Rewrites f into an equivalent formula with double negations, repeated and
+// complementary operands, constants and absorbed operands removed. Chains
+// of & and | are treated as one operator over all their operands. The cost
+// is linear in the size of f: every node is rewritten once, bottom-up.
+//
+// f is left untouched. The result has new nodes but shares the variable
+// nodes of f; release it with Formula::release.
+simplify_result simplify(Formula *f);
+
+// CNF of a formula that is constantly value, over the variable 0
+CNF *constant_cnf(bool value);
+
+#endif /* SIMPLIFY_H */
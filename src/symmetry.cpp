@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <chrono>
+#include <initializer_list>
+#include <vector>
+
+#include "symmetry.h"
+
+// variables in the lex-leader chain of one generator; a shorter chain
+// breaks less of the symmetry but is just as sound
+#define SYMMETRY_MAX_CHAIN 64
+
+// failed candidates allowed when looking for an automorphism that maps
+// one vertex of the first path to another
+#define SYMMETRY_MAX_BACKTRACKS 16
+
+// room for the colorings along the first path
+#define SYMMETRY_MAX_PATH_BYTES (256 << 20)
+
+// A coloring of the graph vertices. Colors are canonical: the color of a
+// cell is the number of vertices in the cells before it, so a cell of
+// color c and size s owns the colors c .. c + s - 1, and two colorings
+// reached by the same steps from the same start agree on their names.
+typedef std::vector<int> coloring;
+
+static uint64_t mix_color(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// The automorphism search of nauty and saucy in its simplest form. The
+// first path individualizes the first vertex of the first non-trivial
+// cell until the coloring is discrete. Then, from the deepest level up,
+// every other vertex w of the cell individualized at level k is tried as
+// the image of the path vertex: the search follows the first path on the
+// other side and checks the permutation its leaf gives. Automorphisms
+// found at deeper levels fix the path above them, so their orbits prune
+// the targets of shallower levels.
+class automorphism_search {
+  int num_vertices;
+  const std::vector<int> &adj_start;
+  const std::vector<int> &adj;
+
+  std::vector<coloring> path;
+  std::vector<int> path_vertex;
+  std::vector<int> path_cell;
+  // vertex of each color at the leaf of the first path
+  std::vector<int> leaf_vertex;
+  std::vector<int> orbit;
+
+  std::chrono::steady_clock::time_point deadline;
+  bool capped;
+  std::vector<int> order;
+  std::vector<uint64_t> signature;
+
+  bool expired() {
+    if (capped && std::chrono::steady_clock::now() >= deadline) stopped_early = true;
+    return stopped_early;
+  }
+
+  int orbit_find(int v) {
+    while (orbit[v] != v) {
+      orbit[v] = orbit[orbit[v]];
+      v = orbit[v];
+    }
+    return v;
+  }
+
+  // Refines color to the coarsest equitable coloring below it: vertices
+  // keep a color only while they see the same number of neighbours of
+  // every color. Neighbourhoods are compared by a hash of the multiset of
+  // their colors. Returns false if the time ran out.
+  bool refine(coloring &color) {
+    int cells = -1;
+    while (true) {
+      if (expired()) return false;
+      for (int v = 0; v < num_vertices; v++) {
+        uint64_t h = 0;
+        for (int i = adj_start[v]; i < adj_start[v + 1]; i++) h += mix_color(color[adj[i]]);
+        signature[v] = h;
+      }
+      std::sort(order.begin(), order.end(), [&](int a, int b) {
+        if (color[a] != color[b]) return color[a] < color[b];
+        return signature[a] < signature[b];
+      });
+
+      int new_cells = 0;
+      int start = 0;
+      std::vector<int> next(num_vertices);
+      for (int i = 0; i < num_vertices; i++) {
+        int v = order[i];
+        if (i > 0) {
+          int u = order[i - 1];
+          if (color[u] != color[v] || signature[u] != signature[v]) start = i;
+        }
+        if (start == i) new_cells++;
+        next[v] = start;
+      }
+      color.swap(next);
+      if (new_cells == cells) return true;
+      cells = new_cells;
+    }
+  }
+
+  static void cell_sizes(const coloring &color, std::vector<int> &size) {
+    size.assign(color.size(), 0);
+    for (size_t v = 0; v < color.size(); v++) size[color[v]]++;
+  }
+
+  // the first cell with more than one vertex, -1 if color is discrete
+  static int target_cell(const std::vector<int> &size) {
+    for (size_t c = 0; c < size.size(); c++) {
+      if (size[c] > 1) return c;
+    }
+    return -1;
+  }
+
+  // moves v into a cell of its own at the end of its cell
+  static void individualize(coloring &color, int v, const std::vector<int> &size) {
+    color[v] += size[color[v]] - 1;
+  }
+
+  static bool compatible(const coloring &a, const coloring &b) {
+    std::vector<int> size_a, size_b;
+    cell_sizes(a, size_a);
+    cell_sizes(b, size_b);
+    return size_a == size_b;
+  }
+
+  bool is_automorphism(const std::vector<int> &perm) {
+    for (int v = 0; v < num_vertices; v++) {
+      if (perm[v] == v) continue;
+      const int *begin = &adj[0] + adj_start[perm[v]];
+      const int *end = &adj[0] + adj_start[perm[v] + 1];
+      if (end - begin != adj_start[v + 1] - adj_start[v]) return false;
+      for (int i = adj_start[v]; i < adj_start[v + 1]; i++) {
+        if (!std::binary_search(begin, end, perm[adj[i]])) return false;
+      }
+    }
+    return true;
+  }
+
+  // follows the first path from level on the other side, with right
+  // compatible with path[level]
+  bool search_right(const coloring &right, size_t level, int &backtracks,
+                    std::vector<int> &perm) {
+    if (level + 1 == path.size()) {
+      for (int v = 0; v < num_vertices; v++) perm[leaf_vertex[right[v]]] = v;
+      return is_automorphism(perm);
+    }
+
+    std::vector<int> size;
+    cell_sizes(right, size);
+    int c = path_cell[level];
+    std::vector<int> candidates;
+    if (right[path_vertex[level]] == c) candidates.push_back(path_vertex[level]);
+    for (int u = 0; u < num_vertices; u++) {
+      if (right[u] == c && u != path_vertex[level]) candidates.push_back(u);
+    }
+
+    for (auto u = candidates.begin(); u != candidates.end(); u++) {
+      if (expired()) return false;
+      coloring next = right;
+      individualize(next, *u, size);
+      if (!refine(next)) return false;
+      if (compatible(next, path[level + 1]) &&
+          search_right(next, level + 1, backtracks, perm)) {
+        return true;
+      }
+      if (--backtracks < 0) return false;
+    }
+    return false;
+  }
+
+public:
+  bool stopped_early;
+
+  automorphism_search(int n, const std::vector<int> &s, const std::vector<int> &a,
+                      double max_seconds) :
+    num_vertices(n), adj_start(s), adj(a), capped(max_seconds > 0), order(n), signature(n),
+    stopped_early(false) {
+    std::chrono::duration<double> cap(max_seconds);
+    deadline = std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(cap);
+    for (int v = 0; v < n; v++) order[v] = v;
+  }
+
+  // appends the automorphisms found to generators
+  void run(const coloring &initial, std::vector<std::vector<int>> &generators) {
+    coloring root = initial;
+    if (!refine(root)) return;
+    path.push_back(root);
+
+    std::vector<int> size;
+    while (true) {
+      cell_sizes(path.back(), size);
+      int c = target_cell(size);
+      if (c < 0) break;
+      if ((path.size() + 1) * num_vertices * sizeof(int) > SYMMETRY_MAX_PATH_BYTES) {
+        stopped_early = true;
+        return;
+      }
+      int v = std::find(path.back().begin(), path.back().end(), c) - path.back().begin();
+      coloring next = path.back();
+      individualize(next, v, size);
+      if (!refine(next)) return;
+      path_vertex.push_back(v);
+      path_cell.push_back(c);
+      path.push_back(next);
+    }
+
+    leaf_vertex.resize(num_vertices);
+    for (int v = 0; v < num_vertices; v++) leaf_vertex[path.back()[v]] = v;
+    orbit.resize(num_vertices);
+    for (int v = 0; v < num_vertices; v++) orbit[v] = v;
+
+    std::vector<int> perm(num_vertices);
+    for (int k = static_cast<int>(path_vertex.size()) - 1; k >= 0; k--) {
+      const coloring &cells = path[k];
+      int v = path_vertex[k];
+      cell_sizes(cells, size);
+      for (int w = 0; w < num_vertices; w++) {
+        if (cells[w] != path_cell[k] || orbit_find(w) == orbit_find(v)) continue;
+        if (expired()) return;
+
+        coloring right = cells;
+        individualize(right, w, size);
+        if (!refine(right)) return;
+        int backtracks = SYMMETRY_MAX_BACKTRACKS;
+        if (!compatible(right, path[k + 1]) || !search_right(right, k + 1, backtracks, perm)) {
+          continue;
+        }
+
+        generators.push_back(perm);
+        for (int u = 0; u < num_vertices; u++) {
+          int a = orbit_find(u), b = orbit_find(perm[u]);
+          if (a != b) orbit[a] = b;
+        }
+      }
+    }
+  }
+};
+
+// Adds the lex-leader constraint x <= x o sigma over the variable order,
+// where sigma maps literals to literals: x_i <= sigma(x_i) wherever the
+// earlier variables equal their images. eq is the auxiliary variable
+// saying that the prefix so far is equal.
+static void lex_leader(const std::vector<int> &sigma, int num_vars, int &next_var, CNF *out,
+                       symmetry_stats &stats) {
+  auto add = [&](std::initializer_list<lit> lits) {
+    Clause *C = new Clause();
+    C->literals.assign(lits.begin(), lits.end());
+    out->clauses.push_back(C);
+    stats.clauses++;
+  };
+
+  std::vector<var> moved;
+  for (var v = 0; v < num_vars; v++) {
+    if (sigma[mk_lit(v, true)] != static_cast<int>(mk_lit(v, true))) moved.push_back(v);
+  }
+  if (moved.size() > SYMMETRY_MAX_CHAIN) moved.resize(SYMMETRY_MAX_CHAIN);
+
+  bool has_eq = false;
+  lit eq = 0;
+  for (size_t i = 0; i < moved.size(); i++) {
+    lit x = mk_lit(moved[i], true);
+    lit y = sigma[x];
+    // x <= !x only holds with x false, and then the prefix differs
+    if (y == lit_neg(x)) {
+      if (has_eq) add({lit_neg(eq), lit_neg(x)});
+      else add({lit_neg(x)});
+      break;
+    }
+    if (has_eq) add({lit_neg(eq), lit_neg(x), y});
+    else add({lit_neg(x), y});
+    if (i + 1 == moved.size()) break;
+
+    // the prefix stays equal when x and y agree: x true, or y false
+    lit next = mk_lit(next_var++, true);
+    stats.aux_vars++;
+    if (has_eq) {
+      add({lit_neg(eq), lit_neg(x), next});
+      add({lit_neg(eq), y, next});
+    } else {
+      add({lit_neg(x), next});
+      add({y, next});
+    }
+    eq = next;
+    has_eq = true;
+  }
+}
+
+int break_symmetries(CNF *cnf, int num_vars, double max_seconds, CNF *out,
+                     symmetry_stats &stats) {
+  auto start = std::chrono::steady_clock::now();
+
+  // equal clauses would only give automorphisms that swap them
+  std::vector<std::vector<lit>> clauses;
+  clauses.reserve(cnf->clauses.size());
+  std::vector<bool> occurs(num_vars, false);
+  for (auto C = cnf->clauses.begin(); C != cnf->clauses.end(); C++) {
+    std::vector<lit> lits = (*C)->literals;
+    std::sort(lits.begin(), lits.end());
+    lits.erase(std::unique(lits.begin(), lits.end()), lits.end());
+    for (auto L = lits.begin(); L != lits.end(); L++) occurs[lit_var(*L)] = true;
+    clauses.push_back(lits);
+  }
+  std::sort(clauses.begin(), clauses.end());
+  clauses.erase(std::unique(clauses.begin(), clauses.end()), clauses.end());
+
+  // literal vertices 0 .. 2n - 1 joined to their negation, then a vertex
+  // per clause joined to its literals
+  int num_lits = 2 * num_vars;
+  int num_vertices = num_lits + clauses.size();
+  std::vector<int> adj_start(num_vertices + 1, 0);
+  for (int L = 0; L < num_lits; L++) adj_start[L + 1] = 1;
+  for (size_t c = 0; c < clauses.size(); c++) {
+    adj_start[num_lits + c + 1] = clauses[c].size();
+    for (auto L = clauses[c].begin(); L != clauses[c].end(); L++) adj_start[*L + 1]++;
+  }
+  for (int v = 0; v < num_vertices; v++) adj_start[v + 1] += adj_start[v];
+
+  std::vector<int> adj(adj_start[num_vertices]);
+  std::vector<int> fill(adj_start.begin(), adj_start.end() - 1);
+  for (int L = 0; L < num_lits; L++) adj[fill[L]++] = L ^ 1;
+  for (size_t c = 0; c < clauses.size(); c++) {
+    int cv = num_lits + c;
+    for (auto L = clauses[c].begin(); L != clauses[c].end(); L++) {
+      adj[fill[cv]++] = *L;
+      adj[fill[*L]++] = cv;
+    }
+  }
+  for (int v = 0; v < num_vertices; v++) {
+    std::sort(adj.begin() + adj_start[v], adj.begin() + adj_start[v + 1]);
+  }
+  clauses.clear();
+  clauses.shrink_to_fit();
+
+  // literals, clauses, then the literals of unused variables, which stay
+  // fixed rather than giving pointless generators
+  coloring initial(num_vertices, 1);
+  for (int L = 0; L < num_lits; L++) initial[L] = occurs[L >> 1] ? 0 : 2 + L;
+
+  std::vector<std::vector<int>> generators;
+  automorphism_search search(num_vertices, adj_start, adj, max_seconds);
+  search.run(initial, generators);
+  stats.stopped_early = search.stopped_early;
+
+  int next_var = num_vars;
+  for (auto g = generators.begin(); g != generators.end(); g++) {
+    lex_leader(*g, num_vars, next_var, out, stats);
+    stats.generators++;
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  stats.seconds = elapsed.count();
+  return next_var;
+}
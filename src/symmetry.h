@@ -0,0 +1,41 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <cstddef>
+
+#include "cnf.h"
+
+struct symmetry_stats {
+  // generators of the symmetry group that were found and broken
+  size_t generators;
+  // lex-leader clauses and their auxiliary variables
+  size_t clauses;
+  size_t aux_vars;
+  double seconds;
+  // the search stopped at the time cap or ran out of room for its path,
+  // so some symmetries may be left unbroken
+  bool stopped_early;
+
+  symmetry_stats() :
+    generators(0), clauses(0), aux_vars(0), seconds(0), stopped_early(false) {}
+};
+
+// Looks for symmetries of cnf: permutations of its literals, negation
+// included, that map the set of clauses onto itself. The CNF is turned
+// into a colored graph with a vertex per literal and per clause, and
+// generators of its automorphism group are searched for by partition
+// refinement and individualization, without any external tool. Every
+// generator is checked against the graph before it is used.
+//
+// Each generator is broken by lex-leader clauses over the variable order,
+// which keep the least model of every symmetry class, so the result stays
+// satisfiable exactly when cnf is. The clauses go into out and use new
+// auxiliary variables from num_vars on; the new number of variables is
+// returned.
+//
+// The search gives up after max_seconds (0 for no cap) and breaks the
+// generators found until then.
+int break_symmetries(CNF *cnf, int num_vars, double max_seconds, CNF *out,
+                     symmetry_stats &stats);
+
+#endif /* SYMMETRY_H */
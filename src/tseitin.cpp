@@ -1,105 +1,86 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <sstream>
-#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "tseitin.h"
 #include "formula.h"
 #include "cnf.h"
 #include "parser.h"
 
-vmap_t *Vmap;
-rmap_t *Rmap;
-
-// var_int to pointer of literal (pos literal, then neg literal)
-struct lpair {
-  Literal *pos;
-  Literal *neg;
-
-  lpair(Literal *p, Literal *n) :
-    pos(p), neg(n) {}
-  void flip() {
-    Literal *temp = pos;
-    pos = neg;
-    neg = temp;
-  }
-};
-
-typedef std::vector<lpair> lmap_t;
-lmap_t *Lmap;
+// per thread, so that several threads can transform formulas at once
+thread_local vmap_t *Vmap;
+thread_local rmap_t *Rmap;
 
 struct tseitin_unit {
-  lpair A;
-  lpair B;
-  lpair C;
+  lit A;
+  lit B;
+  lit C;
   Connective op;
   bool is_unary;
 
-  tseitin_unit(lpair a, lpair b, lpair c, Connective conn) :
+  tseitin_unit(lit a, lit b, lit c, Connective conn) :
     A(a), B(b), C(c), op(conn), is_unary(false) {}
 
   // Create a unary tseitin_unit, B is useless in this case
-  tseitin_unit(lpair a, lpair c) :
-    A(a), B(c), C(c), is_unary(true) {}
+  tseitin_unit(lit a, lit c) :
+    A(a), B(c), C(c), op(land), is_unary(true) {}
 
   std::string print() const {
     std::ostringstream oss;
-    oss << *(A.pos) << ";"
-        << *(B.pos) << ";"
-        << *(C.pos) << ";"
-        << static_cast<int>(op);
+    print_lit(oss, A);
+    oss << ";";
+    print_lit(oss, B);
+    oss << ";";
+    print_lit(oss, C);
+    oss << ";" << static_cast<int>(op);
     return oss.str();
   }
 };
 
-bool tseitin_unit_compare(const tseitin_unit &P, const tseitin_unit &Q) {
-  return P.print() < Q.print();
+// returns the positive literal of variable f
+lit variable_lit(Formula *f) {
+  Variable *v = static_cast<Variable *>(f);
+  return mk_lit(v->var, true);
 }
 
-typedef std::set<tseitin_unit, bool(*)(const tseitin_unit &A, const tseitin_unit &B)> tu_set;
-
-
-lpair find_or_assign_var(Formula *f) {
-  if (f->type == Formula::variable) {
-    Variable *v = static_cast<Variable *>(f);
-    return (*Lmap)[v->var];
-  }
-
-  std::ostringstream name_stream;
-  name_stream << *f;
-  std::string var_name = name_stream.str();
+// returns the positive literal of the auxiliary variable named var_name
+lit find_or_assign_named(const std::string &var_name) {
   auto var_int_it = Vmap->find(var_name);
   if (var_int_it == Vmap->end()) {
     // new var
     int var_int = Rmap->size();
     (*Vmap)[var_name] = var_int;
     Rmap->push_back(var_name);
-    lpair lp = lpair(new Literal(var_int, true),
-                     new Literal(var_int, false));
-    Lmap->push_back(lp);
-    return lp;
+    return mk_lit(var_int, true);
   }
 
-  return (*Lmap)[(*Vmap)[var_name]];
+  return mk_lit(var_int_it->second, true);
 }
 
 // transform from C <-> (A & B) to CNF
 // heuristic:
 //   C <-> (A & B) = (!A | !B | C) & (A | !C) & (B | !C)
-CNF *tseitin_basic_land(lpair A, lpair B, lpair C) {
+CNF *tseitin_basic_land(lit A, lit B, lit C) {
   CNF *result = new CNF();
   Clause *cl1 = new Clause();
   Clause *cl2 = new Clause();
   Clause *cl3 = new Clause();
 
-  cl1->literals.push_back(A.neg);
-  cl1->literals.push_back(B.neg);
-  cl1->literals.push_back(C.pos);
+  cl1->literals.push_back(lit_neg(A));
+  cl1->literals.push_back(lit_neg(B));
+  cl1->literals.push_back(C);
 
-  cl2->literals.push_back(A.pos);
-  cl2->literals.push_back(C.neg);
+  cl2->literals.push_back(A);
+  cl2->literals.push_back(lit_neg(C));
 
-  cl3->literals.push_back(B.pos);
-  cl3->literals.push_back(C.neg);
+  cl3->literals.push_back(B);
+  cl3->literals.push_back(lit_neg(C));
 
   result->clauses.push_back(cl1);
   result->clauses.push_back(cl2);
@@ -108,48 +89,50 @@ CNF *tseitin_basic_land(lpair A, lpair B, lpair C) {
   return result;
 }
 
-CNF *tseitin_basic_lor(lpair A, lpair B, lpair C) {
-  A.flip();
-  B.flip();
-  C.flip();
-
-  return tseitin_basic_land(A, B, C);
+CNF *tseitin_basic_lor(lit A, lit B, lit C) {
+  return tseitin_basic_land(lit_neg(A), lit_neg(B), lit_neg(C));
 }
 
-CNF *tseitin_basic_not(lpair A, lpair C) {
+CNF *tseitin_basic_not(lit A, lit C) {
   CNF *result = new CNF();
   Clause *cl1 = new Clause();
   Clause *cl2 = new Clause();
 
-  cl1->literals.push_back(A.neg);
-  cl1->literals.push_back(C.neg);
+  cl1->literals.push_back(lit_neg(A));
+  cl1->literals.push_back(lit_neg(C));
 
-  cl2->literals.push_back(A.pos);
-  cl2->literals.push_back(C.pos);
+  cl2->literals.push_back(A);
+  cl2->literals.push_back(C);
 
   result->clauses.push_back(cl1);
   result->clauses.push_back(cl2);
   return result;
 }
 
-CNF *tseitin_basic_lequiv(lpair A, lpair B, lpair C) {
+// transform from C <-> (A <-> B) to CNF
+//   = (!A | !B | C) & (A | B | C) & (A | !B | !C) & (!A | B | !C)
+CNF *tseitin_basic_lequiv(lit A, lit B, lit C) {
   CNF *result = new CNF();
   Clause *cl1 = new Clause();
   Clause *cl2 = new Clause();
   Clause *cl3 = new Clause();
   Clause *cl4 = new Clause();
 
-  cl1->literals.push_back(A.neg);
-  cl1->literals.push_back(B.pos);
+  cl1->literals.push_back(lit_neg(A));
+  cl1->literals.push_back(lit_neg(B));
+  cl1->literals.push_back(C);
 
-  cl2->literals.push_back(A.pos);
-  cl2->literals.push_back(B.neg);
+  cl2->literals.push_back(A);
+  cl2->literals.push_back(B);
+  cl2->literals.push_back(C);
 
-  cl3->literals.push_back(B.neg);
-  cl3->literals.push_back(C.pos);
+  cl3->literals.push_back(A);
+  cl3->literals.push_back(lit_neg(B));
+  cl3->literals.push_back(lit_neg(C));
 
-  cl4->literals.push_back(B.pos);
-  cl4->literals.push_back(C.neg);
+  cl4->literals.push_back(lit_neg(A));
+  cl4->literals.push_back(B);
+  cl4->literals.push_back(lit_neg(C));
 
   result->clauses.push_back(cl1);
   result->clauses.push_back(cl2);
@@ -158,38 +141,163 @@ CNF *tseitin_basic_lequiv(lpair A, lpair B, lpair C) {
   return result;
 }
 
-// generate tseitin units
-void gen_tu(Formula *f, tu_set *tus) {
-  switch (f->type) {
-    case Formula::binary:
-      {
-        Binary *b = static_cast<Binary *>(f);
-        gen_tu(b->l, tus);
-        tus->emplace(find_or_assign_var(b->l),
-                     find_or_assign_var(b->r),
-                     find_or_assign_var(b),
-                     b->op);
-        gen_tu(b->r, tus);
+/*
+ * cardinality constraints
+ *
+ * The operands are summed into a unary counter: out[j-1] <-> at least j
+ * operands are true, for j up to a cap of k+1. Counters are combined by a
+ * totalizer merge whose clauses define every output in both directions, so
+ * the auxiliaries are functions of the operands like all other Tseitin
+ * variables. Merging in one more operand at a time gives the sequential
+ * counter, merging balanced halves the totalizer; whichever needs fewer
+ * clauses for the given n and k is used. Both stay near n*k clauses.
+ */
+
+typedef std::vector<lit> unary_count;
+
+bool parse_into_literal(Formula *f, bool negate, lit *L);
+
+// number of clauses of a capped merge of counters with p and q outputs
+size_t merge_cost(int p, int q, int cap) {
+  int len = std::min(p + q, cap);
+  size_t cost = 0;
+  for (int i = 0; i <= p; i++) {
+    for (int j = 0; j <= q; j++) {
+      if (i + j >= 1 && i + j <= len) cost++;
+      if (i + j + 1 <= len) cost++;
+    }
+  }
+  return cost;
+}
+
+size_t totalizer_cost(int n, int cap) {
+  if (n <= 1) return 0;
+  int l = n / 2;
+  return totalizer_cost(l, cap) + totalizer_cost(n - l, cap) +
+         merge_cost(std::min(l, cap), std::min(n - l, cap), cap);
+}
+
+size_t seqcounter_cost(int n, int cap) {
+  size_t cost = 0;
+  for (int i = 1; i < n; i++) cost += merge_cost(std::min(i, cap), 1, cap);
+  return cost;
+}
+
+// r[s-1] <-> a + b >= s, for s up to cap
+unary_count merge_counts(const unary_count &a, const unary_count &b, int cap,
+                         const std::string &name, CNF *out) {
+  int p = a.size();
+  int q = b.size();
+  int len = std::min(p + q, cap);
+
+  unary_count r;
+  for (int s = 1; s <= len; s++) {
+    r.push_back(find_or_assign_named(name + "." + std::to_string(s)));
+  }
+
+  for (int i = 0; i <= p; i++) {
+    for (int j = 0; j <= q; j++) {
+      // a >= i and b >= j  ->  r >= i+j
+      if (i + j >= 1 && i + j <= len) {
+        Clause *C = new Clause();
+        if (i > 0) C->literals.push_back(lit_neg(a[i - 1]));
+        if (j > 0) C->literals.push_back(lit_neg(b[j - 1]));
+        C->literals.push_back(r[i + j - 1]);
+        out->clauses.push_back(C);
       }
+      // a <= i and b <= j  ->  r <= i+j
+      if (i + j + 1 <= len) {
+        Clause *C = new Clause();
+        if (i < p) C->literals.push_back(a[i]);
+        if (j < q) C->literals.push_back(b[j]);
+        C->literals.push_back(lit_neg(r[i + j]));
+        out->clauses.push_back(C);
+      }
+    }
+  }
+  return r;
+}
+
+unary_count totalizer(const std::vector<lit> &inputs, size_t lo, size_t hi, int cap,
+                      const std::string &name, int *node, CNF *out) {
+  if (hi - lo == 1) return unary_count(1, inputs[lo]);
+  size_t mid = lo + (hi - lo) / 2;
+  unary_count a = totalizer(inputs, lo, mid, cap, name, node, out);
+  unary_count b = totalizer(inputs, mid, hi, cap, name, node, out);
+  return merge_counts(a, b, cap, name + "#" + std::to_string((*node)++), out);
+}
+
+unary_count seqcounter(const std::vector<lit> &inputs, int cap, const std::string &name, CNF *out) {
+  unary_count acc(1, inputs[0]);
+  for (size_t i = 1; i < inputs.size(); i++) {
+    acc = merge_counts(acc, unary_count(1, inputs[i]), cap, name + "#" + std::to_string(i), out);
+  }
+  return acc;
+}
+
+void add_unit(CNF *cnf, lit L) {
+  Clause *C = new Clause();
+  C->literals.push_back(L);
+  cnf->clauses.push_back(C);
+}
+
+// C <-> card over the operand literals inputs, with counter variables
+// named after name
+void encode_cardinality(Cardinality *card, lit C, const std::vector<lit> &inputs,
+                        const std::string &name, CNF *out) {
+  int n = inputs.size();
+  int k = card->k;
+
+  // trivial bounds and the number of counter outputs needed
+  int cap = 0;
+  switch (card->bound) {
+    case atmost:
+      if (k >= n) return add_unit(out, C);
+      if (k < 0) return add_unit(out, lit_neg(C));
+      cap = k + 1;
       break;
-    case Formula::variable:
+    case atleast:
+      if (k <= 0) return add_unit(out, C);
+      if (k > n) return add_unit(out, lit_neg(C));
+      cap = k;
       break;
-    case Formula::negated:
-      {
-        Negated *n = static_cast<Negated *>(f);
-        tus->emplace(find_or_assign_var(n->f),
-                     find_or_assign_var(n));
-        gen_tu(n->f, tus);
+    case exactly:
+      if (k < 0 || k > n) return add_unit(out, lit_neg(C));
+      cap = std::min(k + 1, n);
+      break;
+  }
+
+  unary_count r;
+  if (seqcounter_cost(n, cap) <= totalizer_cost(n, cap)) {
+    r = seqcounter(inputs, cap, name, out);
+  } else {
+    int node = 1;
+    r = totalizer(inputs, 0, n, cap, name, &node, out);
+  }
+
+  switch (card->bound) {
+    case atmost:
+      merge_cnf(out, tseitin_basic_not(r[k], C));
+      break;
+    case atleast:
+      merge_cnf(out, tseitin_basic_not(lit_neg(r[k - 1]), C));
+      break;
+    case exactly:
+      if (k == 0) {
+        merge_cnf(out, tseitin_basic_not(r[0], C));
+      } else if (k == n) {
+        merge_cnf(out, tseitin_basic_not(lit_neg(r[n - 1]), C));
+      } else {
+        merge_cnf(out, tseitin_basic_land(r[k - 1], lit_neg(r[k]), C));
       }
       break;
   }
 }
 
 CNF *tu_to_cnf(const tseitin_unit &tu) {
-  // make copies
-  lpair A = tu.A;
-  lpair B = tu.B;
-  lpair C = tu.C;
+  lit A = tu.A;
+  lit B = tu.B;
+  lit C = tu.C;
 
   if (tu.is_unary) {
     return tseitin_basic_not(A, C);
@@ -201,34 +309,23 @@ CNF *tu_to_cnf(const tseitin_unit &tu) {
     case lor:
       return tseitin_basic_lor(A, B, C);
     case limply:
-      A.flip();
-      return tseitin_basic_lor(A, B, C);
+      return tseitin_basic_lor(lit_neg(A), B, C);
     case lequiv:
       return tseitin_basic_lequiv(A, B, C);
   }
 }
 
-CNF *tu_set_to_cnf(tu_set *tus) {
-  CNF *result = new CNF();
-
-  for (auto it = tus->begin(); it != tus->end(); it++) {
-    merge_cnf(result, tu_to_cnf(*it));
-  }
-
-  return result;
-}
-
 // direct parse into CNF
-Literal *parse_into_literal(Formula *f, bool negate) {
+bool parse_into_literal(Formula *f, bool negate, lit *L) {
   if (f->type == Formula::variable) {
-      lpair Vp = find_or_assign_var(f);
-      if (negate) return Vp.neg;
-      return Vp.pos;
+      lit V = variable_lit(f);
+      *L = negate ? lit_neg(V) : V;
+      return true;
   } else if (f->type == Formula::negated) {
       Negated *nv = static_cast<Negated *>(f);
-      return parse_into_literal(nv->f, !negate);
+      return parse_into_literal(nv->f, !negate, L);
   }
-  return nullptr;
+  return false;
 }
 
 Clause *parse_into_clause(Formula *f) {
@@ -237,11 +334,15 @@ Clause *parse_into_clause(Formula *f) {
     if (b->op != lor) return nullptr;
     Clause *left_res = parse_into_clause(b->l);
     Clause *right_res = parse_into_clause(b->r);
-    if (!left_res || !right_res) return nullptr;
+    if (!left_res || !right_res) {
+      delete left_res;
+      delete right_res;
+      return nullptr;
+    }
     return merge_clause(left_res, right_res);
   } else {
-    Literal *L = parse_into_literal(f, false);
-    if (!L) return nullptr;
+    lit L;
+    if (!parse_into_literal(f, false, &L)) return nullptr;
     Clause *C = new Clause();
     C->literals.push_back(L);
     return C;
@@ -256,7 +357,11 @@ CNF *parse_into_cnf(Formula *f) {
       // could be cnf
       CNF *left_result = parse_into_cnf(b->l);
       CNF *right_result = parse_into_cnf(b->r);
-      if (!left_result || !right_result) return nullptr;
+      if (!left_result || !right_result) {
+        if (left_result) free_cnf(left_result);
+        if (right_result) free_cnf(right_result);
+        return nullptr;
+      }
       return merge_cnf(left_result, right_result);
     } else if (b->op == lor) {
       // do nothing here so it falls out of 'if' case
@@ -278,32 +383,347 @@ void tseitin_init(vmap_t *vmap, rmap_t *rmap) {
   // initialize global data
   Vmap = vmap;
   Rmap = rmap;
+}
+
+/*
+ * full transform
+ *
+ * Every non-variable node gets an auxiliary variable named after its
+ * subformula, so equal subformulas share one variable and one definition.
+ * Within names, operands printing longer than TSEITIN_MAX_NAME_CHARS are
+ * replaced by their variable, e.g. (#12&c), which keeps the names of long
+ * chains from growing with the square of the chain.
+ *
+ * The nodes are listed in post-order (operands before the node) and cut
+ * into chunks of TSEITIN_CHUNK_NODES. Workers print the names of whole
+ * chunks, variables are assigned in list order on the calling thread, then
+ * workers write the defining clauses of each chunk into a buffer of its
+ * own, and the buffers are passed on in chunk order. The chunks depend
+ * only on the formula, so the CNF is the same for any number of threads.
+ */
+
+// longest subformula used as a variable name as it is
+#define TSEITIN_MAX_NAME_CHARS 80
+// nodes per chunk of work
+#define TSEITIN_CHUNK_NODES 4096
+// below this many nodes, everything runs on the calling thread
+#define TSEITIN_PARALLEL_MIN_NODES 65536
+// chunks whose clauses are generated before any is passed on, at least
+#define TSEITIN_WINDOW_CHUNKS 16
+
+#define NO_CHILD SIZE_MAX
+
+struct tseitin_node {
+  Formula *f;
+  size_t child[2];   // list index of a non-variable binary or negated operand
+  size_t length;     // printed length, capped at TSEITIN_MAX_NAME_CHARS + 1
+  lit L;
+  bool defines;      // first node with its name, its clauses are emitted
+
+  tseitin_node(Formula *ff) : f(ff), length(0), L(0), defines(false) {
+    child[0] = child[1] = NO_CHILD;
+  }
+};
+
+struct tseitin_nodes {
+  std::vector<tseitin_node> list;
+  // list indices of the non-literal operands of cardinality nodes
+  std::unordered_map<size_t, std::vector<size_t> > card_children;
+};
+
+// post-order list of the non-variable nodes below root, with an explicit
+// stack since long chains are far deeper than the call stack allows
+void collect_nodes(Formula *root, tseitin_nodes &nodes) {
+  // reversed pre-order visiting the last operand first is post-order
+  struct pending {
+    Formula *f;
+    size_t parent;
+    size_t slot;
+  };
+  std::vector<pending> stack;
+  std::vector<pending> parent;
+  stack.push_back(pending{root, NO_CHILD, 0});
+
+  while (!stack.empty()) {
+    pending p = stack.back();
+    stack.pop_back();
+    if (p.f->type == Formula::variable) continue;
+
+    size_t i = nodes.list.size();
+    nodes.list.emplace_back(p.f);
+    parent.push_back(p);
+    switch (p.f->type) {
+      case Formula::binary:
+        {
+          Binary *b = static_cast<Binary *>(p.f);
+          stack.push_back(pending{b->l, i, 0});
+          stack.push_back(pending{b->r, i, 1});
+        }
+        break;
+      case Formula::negated:
+        stack.push_back(pending{static_cast<Negated *>(p.f)->f, i, 0});
+        break;
+      case Formula::cardinality:
+        {
+          // literal operands are used directly
+          Cardinality *c = static_cast<Cardinality *>(p.f);
+          for (size_t k = 0; k < c->operands.size(); k++) {
+            lit L;
+            if (!parse_into_literal(c->operands[k], false, &L)) {
+              stack.push_back(pending{c->operands[k], i, k});
+            }
+          }
+        }
+        break;
+      case Formula::variable:
+        break;
+    }
+  }
+
+  size_t n = nodes.list.size();
+  std::reverse(nodes.list.begin(), nodes.list.end());
+  for (size_t i = 0; i < n; i++) {
+    if (parent[i].parent == NO_CHILD) continue;
+    size_t p = n - 1 - parent[i].parent;
+    tseitin_node &node = nodes.list[p];
+    if (node.f->type == Formula::cardinality) {
+      std::vector<size_t> &children = nodes.card_children[p];
+      children.resize(static_cast<Cardinality *>(node.f)->operands.size(), NO_CHILD);
+      children[parent[i].slot] = n - 1 - i;
+    } else {
+      node.child[parent[i].slot] = n - 1 - i;
+    }
+  }
+}
+
+size_t cap_length(size_t length) {
+  return std::min<size_t>(length, TSEITIN_MAX_NAME_CHARS + 1);
+}
+
+// printed length of operand, the list index of which is child
+size_t operand_length(const tseitin_nodes &nodes, size_t child, Formula *operand) {
+  if (child != NO_CHILD) return nodes.list[child].length;
+  std::ostringstream oss;
+  oss << *operand;   // a variable or a negated variable
+  return oss.str().size();
+}
+
+void compute_lengths(tseitin_nodes &nodes) {
+  for (size_t i = 0; i < nodes.list.size(); i++) {
+    tseitin_node &node = nodes.list[i];
+    size_t length = 0;
+    switch (node.f->type) {
+      case Formula::binary:
+        {
+          Binary *b = static_cast<Binary *>(node.f);
+          length = 2 + (b->op == lequiv ? 3 : b->op == limply ? 2 : 1) +
+                   operand_length(nodes, node.child[0], b->l) +
+                   operand_length(nodes, node.child[1], b->r);
+        }
+        break;
+      case Formula::negated:
+        length = 1 + operand_length(nodes, node.child[0], static_cast<Negated *>(node.f)->f);
+        break;
+      case Formula::cardinality:
+        {
+          Cardinality *c = static_cast<Cardinality *>(node.f);
+          auto children = nodes.card_children.find(i);
+          length = std::strlen(Cardinality::keyword(c->bound)) + 2 + std::to_string(c->k).size();
+          for (size_t k = 0; k < c->operands.size() && length <= TSEITIN_MAX_NAME_CHARS; k++) {
+            size_t child = children == nodes.card_children.end() ? NO_CHILD : children->second[k];
+            length += 1 + operand_length(nodes, child, c->operands[k]);
+          }
+        }
+        break;
+      case Formula::variable:
+        break;
+    }
+    node.length = cap_length(length);
+  }
+}
+
+// name of an operand inside the short name of a long subformula
+std::string operand_ref(const tseitin_nodes &nodes, size_t child, Formula *operand) {
+  if (child == NO_CHILD) {
+    std::ostringstream oss;
+    oss << *operand;
+    return oss.str();
+  }
+  const tseitin_node &node = nodes.list[child];
+  if (node.length <= TSEITIN_MAX_NAME_CHARS) return (*Rmap)[lit_var(node.L)];
+  return "#" + std::to_string(lit_var(node.L));
+}
+
+// name of node i printing longer than TSEITIN_MAX_NAME_CHARS, once its
+// operands have their variables
+std::string short_name(const tseitin_nodes &nodes, size_t i) {
+  const tseitin_node &node = nodes.list[i];
+  std::string name;
+  switch (node.f->type) {
+    case Formula::binary:
+      {
+        Binary *b = static_cast<Binary *>(node.f);
+        const char *op = b->op == land ? "&" : b->op == lor ? "|" : b->op == limply ? "->" : "<->";
+        name = "(" + operand_ref(nodes, node.child[0], b->l) + op +
+               operand_ref(nodes, node.child[1], b->r) + ")";
+      }
+      break;
+    case Formula::negated:
+      name = "!" + operand_ref(nodes, node.child[0], static_cast<Negated *>(node.f)->f);
+      break;
+    case Formula::cardinality:
+      {
+        Cardinality *c = static_cast<Cardinality *>(node.f);
+        auto children = nodes.card_children.find(i);
+        name = std::string(Cardinality::keyword(c->bound)) + "(" + std::to_string(c->k);
+        for (size_t k = 0; k < c->operands.size(); k++) {
+          size_t child = children == nodes.card_children.end() ? NO_CHILD : children->second[k];
+          name += "," + operand_ref(nodes, child, c->operands[k]);
+        }
+        name += ")";
+      }
+      break;
+    case Formula::variable:
+      break;
+  }
+  return name;
+}
+
+// literal standing for operand, the list index of which is child
+lit operand_lit(const tseitin_nodes &nodes, size_t child, Formula *operand) {
+  if (child != NO_CHILD) return nodes.list[child].L;
+  lit L = 0;
+  parse_into_literal(operand, false, &L);
+  return L;
+}
 
-  Lmap = new lmap_t();
-  for (int i = 0; i < Rmap->size(); i++) {
-    Lmap->emplace_back(new Literal(i, true), new Literal(i, false));
+// runs work(chunk) for every chunk, spread over num_threads threads
+template <class Work>
+void for_each_chunk(size_t num_chunks, int num_threads, Work work) {
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    size_t k;
+    while ((k = next++) < num_chunks) work(k);
+  };
+
+  if (num_threads <= 1 || num_chunks <= 1) {
+    worker();
+  } else {
+    std::vector<std::thread> workers;
+    for (int t = 0; t < num_threads; t++) workers.emplace_back(worker);
+    for (auto it = workers.begin(); it != workers.end(); it++) it->join();
   }
 }
 
-CNF *tseitin_transform(Formula *f) {
-  CNF *result;
+void tseitin_transform(Formula *f, int num_threads, clause_sink &out) {
+  tseitin_nodes nodes;
+  collect_nodes(f, nodes);
+  compute_lengths(nodes);
+
+  size_t n = nodes.list.size();
+  size_t num_chunks = (n + TSEITIN_CHUNK_NODES - 1) / TSEITIN_CHUNK_NODES;
+  if (n < TSEITIN_PARALLEL_MIN_NODES) num_threads = 1;
+  auto chunk_range = [n](size_t k, size_t *lo, size_t *hi) {
+    *lo = k * TSEITIN_CHUNK_NODES;
+    *hi = std::min(n, *lo + TSEITIN_CHUNK_NODES);
+  };
+
+  // print the names of the short subformulas
+  std::vector<std::string> names(n);
+  for_each_chunk(num_chunks, num_threads, [&](size_t k) {
+    size_t lo, hi;
+    chunk_range(k, &lo, &hi);
+    std::ostringstream name_stream;
+    for (size_t i = lo; i < hi; i++) {
+      if (nodes.list[i].length > TSEITIN_MAX_NAME_CHARS) continue;
+      name_stream.str("");
+      name_stream << *nodes.list[i].f;
+      names[i] = name_stream.str();
+    }
+  });
+
+  // assign the variables in list order
+  Vmap->reserve(Vmap->size() + n);
+  for (size_t i = 0; i < n; i++) {
+    tseitin_node &node = nodes.list[i];
+    if (node.length > TSEITIN_MAX_NAME_CHARS) names[i] = short_name(nodes, i);
+    auto var_int_it = Vmap->find(names[i]);
+    if (var_int_it == Vmap->end()) {
+      int var_int = Rmap->size();
+      Vmap->emplace(names[i], var_int);
+      Rmap->push_back(std::move(names[i]));
+      node.L = mk_lit(var_int, true);
+      node.defines = true;
+    } else {
+      node.L = mk_lit(var_int_it->second, true);
+    }
+    std::string().swap(names[i]);
+  }
 
-  // do full tseitin
-  tu_set tus(&tseitin_unit_compare);
-  gen_tu(f, &tus);
+  // defining clauses, written by the workers into one buffer per chunk and
+  // passed on in chunk order a window of chunks at a time, so that a sink
+  // that writes them out never holds more than a window
+  size_t window = std::max<size_t>(TSEITIN_WINDOW_CHUNKS, 4 * num_threads);
+  std::vector<std::vector<Clause *> > buffers(window);
+  for (size_t first = 0; first < num_chunks; first += window) {
+    size_t last = std::min(num_chunks, first + window);
+    for_each_chunk(last - first, num_threads, [&](size_t w) {
+      size_t lo, hi;
+      chunk_range(first + w, &lo, &hi);
+      for (size_t i = lo; i < hi; i++) {
+        const tseitin_node &node = nodes.list[i];
+        if (!node.defines) continue;
+        CNF *def;
+        if (node.f->type == Formula::binary) {
+          Binary *b = static_cast<Binary *>(node.f);
+          def = tu_to_cnf(tseitin_unit(operand_lit(nodes, node.child[0], b->l),
+                                       operand_lit(nodes, node.child[1], b->r), node.L, b->op));
+        } else if (node.f->type == Formula::negated) {
+          Negated *neg = static_cast<Negated *>(node.f);
+          def = tu_to_cnf(tseitin_unit(operand_lit(nodes, node.child[0], neg->f), node.L));
+        } else {
+          continue;
+        }
+        buffers[w].insert(buffers[w].end(), def->clauses.begin(), def->clauses.end());
+        delete def;
+      }
+    });
 
-  // print the basic tseitin units
-  // for (auto it = tus.begin(); it != tus.end(); it++) {
-  //   std::cout << (*it).print() << std::endl;
-  // }
+    for (size_t w = 0; w < last - first; w++) {
+      for (auto it = buffers[w].begin(); it != buffers[w].end(); it++) out.add_clause(*it);
+      buffers[w].clear();
+    }
+  }
 
-  result = tu_set_to_cnf(&tus);
+  // cardinality constraints name their counter variables, so they are
+  // encoded here on the calling thread
+  for (size_t i = 0; i < n; i++) {
+    const tseitin_node &node = nodes.list[i];
+    if (!node.defines || node.f->type != Formula::cardinality) continue;
+    Cardinality *c = static_cast<Cardinality *>(node.f);
+    auto children = nodes.card_children.find(i);
+    std::vector<lit> inputs;
+    for (size_t k = 0; k < c->operands.size(); k++) {
+      size_t child = children == nodes.card_children.end() ? NO_CHILD : children->second[k];
+      inputs.push_back(operand_lit(nodes, child, c->operands[k]));
+    }
+    // a copy, the counter variables grow Rmap
+    std::string name = (*Rmap)[lit_var(node.L)];
+    CNF *def = new CNF();
+    encode_cardinality(c, node.L, inputs, name, def);
+    for (auto it = def->clauses.begin(); it != def->clauses.end(); it++) out.add_clause(*it);
+    delete def;
+  }
 
   // add the var representing the entire formula to result
-  lpair entire_formula = find_or_assign_var(f);
+  lit entire_formula = n ? nodes.list[n - 1].L : variable_lit(f);
   Clause *C = new Clause();
-  C->literals.push_back(entire_formula.pos);
-  result->clauses.push_back(C);
+  C->literals.push_back(entire_formula);
+  out.add_clause(C);
+}
 
-  return result;
-}
\ No newline at end of file
+CNF *tseitin_transform(Formula *f, int num_threads) {
+  cnf_builder builder;
+  tseitin_transform(f, num_threads, builder);
+  return builder.cnf;
+}
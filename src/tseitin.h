@@ -5,7 +5,12 @@
 #include "parser.h"
 
 void tseitin_init(vmap_t *vmap, rmap_t *rmap);
-CNF *tseitin_transform(Formula *f);
+// Tseitin transform of f; large formulas are encoded on up to num_threads
+// threads, with the same result for any number of threads
+CNF *tseitin_transform(Formula *f, int num_threads = 1);
+// the same, passing the clauses to out in order as they are generated; the
+// memory held besides the sink grows with f, not with the CNF
+void tseitin_transform(Formula *f, int num_threads, clause_sink &out);
 CNF *parse_into_cnf(Formula *f);
 
 #endif /* TSEITIN_H */
\ No newline at end of file
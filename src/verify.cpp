@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "verify.h"
+
+// below this many clauses, spawning threads costs more than it saves
+#define PARALLEL_VERIFY_MIN_CLAUSES (1 << 16)
+
+// index of the first falsified clause in [begin, end), or end if none
+static size_t check_range(CNF *cnf, const std::vector<uint8_t> &lit_true,
+                          size_t begin, size_t end) {
+  const uint8_t *vals = lit_true.data();
+
+  for (size_t i = begin; i < end; i++) {
+    const std::vector<lit> &lits = cnf->clauses[i]->literals;
+    const lit *L = lits.data();
+    size_t n = lits.size();
+
+    // branch-free OR over the clause so the loop can be vectorized
+    uint8_t sat = 0;
+    for (size_t j = 0; j < n; j++) sat |= vals[L[j]];
+
+    if (!sat) return i;
+  }
+
+  return end;
+}
+
+Clause *verify_cnf(CNF *cnf, assignment &asmt, int num_threads) {
+  // literal-indexed truth table, 1 if the literal is true under asmt
+  std::vector<uint8_t> lit_true(2 * asmt.size());
+  for (size_t v = 0; v < asmt.size(); v++) {
+    lit_true[mk_lit(v, true)] = asmt[v] ? 1 : 0;
+    lit_true[mk_lit(v, false)] = asmt[v] ? 0 : 1;
+  }
+
+  size_t num_clauses = cnf->clauses.size();
+  if (num_threads < 1) num_threads = 1;
+  if (num_clauses < PARALLEL_VERIFY_MIN_CLAUSES) num_threads = 1;
+
+  size_t failed;
+  if (num_threads == 1) {
+    failed = check_range(cnf, lit_true, 0, num_clauses);
+  } else {
+    std::vector<size_t> first_failed(num_threads, num_clauses);
+    std::vector<std::thread> workers;
+    size_t chunk = (num_clauses + num_threads - 1) / num_threads;
+
+    for (int t = 0; t < num_threads; t++) {
+      size_t begin = std::min(t * chunk, num_clauses);
+      size_t end = std::min(begin + chunk, num_clauses);
+      workers.emplace_back([=, &lit_true, &first_failed]() {
+        size_t res = check_range(cnf, lit_true, begin, end);
+        if (res != end) first_failed[t] = res;
+      });
+    }
+
+    for (auto it = workers.begin(); it != workers.end(); it++) it->join();
+    failed = *std::min_element(first_failed.begin(), first_failed.end());
+  }
+
+  if (failed == num_clauses) return nullptr;
+  return cnf->clauses[failed];
+}
+
+size_t verify_binaries(const std::vector<std::pair<lit, lit> > &binaries, assignment &asmt) {
+  for (size_t i = 0; i < binaries.size(); i++) {
+    lit a = binaries[i].first;
+    lit b = binaries[i].second;
+    if (asmt[lit_var(a)] != lit_is_pos(a) && asmt[lit_var(b)] != lit_is_pos(b)) return i;
+  }
+  return binaries.size();
+}
+
+bool verify_formula(Formula *f, assignment &asmt) {
+  switch (f->type) {
+    case Formula::variable:
+      return asmt[static_cast<Variable *>(f)->var];
+    case Formula::negated:
+      return !verify_formula(static_cast<Negated *>(f)->f, asmt);
+    case Formula::binary:
+      {
+        Binary *b = static_cast<Binary *>(f);
+        bool l = verify_formula(b->l, asmt);
+        bool r = verify_formula(b->r, asmt);
+        switch (b->op) {
+          case land:
+            return l && r;
+          case lor:
+            return l || r;
+          case limply:
+            return !l || r;
+          case lequiv:
+            return l == r;
+        }
+      }
+      break;
+    case Formula::cardinality:
+      {
+        Cardinality *c = static_cast<Cardinality *>(f);
+        int num_true = 0;
+        for (auto it = c->operands.begin(); it != c->operands.end(); it++) {
+          if (verify_formula(*it, asmt)) num_true++;
+        }
+        switch (c->bound) {
+          case atmost:
+            return num_true <= c->k;
+          case atleast:
+            return num_true >= c->k;
+          case exactly:
+            return num_true == c->k;
+        }
+      }
+      break;
+  }
+  return false;
+}
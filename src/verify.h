@@ -0,0 +1,24 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "cnf.h"
+#include "dpll.h"
+#include "formula.h"
+
+// returns the first clause falsified by asmt, or nullptr if every clause is
+// satisfied. asmt must cover every variable used in cnf.
+// large inputs are split across up to num_threads threads.
+Clause *verify_cnf(CNF *cnf, assignment &asmt, int num_threads = 1);
+
+// the index of the first binary clause falsified by asmt, or
+// binaries.size() if every one is satisfied
+size_t verify_binaries(const std::vector<std::pair<lit, lit> > &binaries, assignment &asmt);
+
+// evaluates the original formula under asmt
+bool verify_formula(Formula *f, assignment &asmt);
+
+#endif /* VERIFY_H */
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "xor.h"
+
+void extract_xors(CNF *cnf, int max_size, std::vector<xor_constraint> &xors, CNF *rest) {
+  // clauses grouped by their (sorted, distinct) variable set
+  std::map<std::vector<var>, std::vector<int> > groups;
+  std::vector<bool> used(cnf->clauses.size(), false);
+
+  for (size_t i = 0; i < cnf->clauses.size(); i++) {
+    std::vector<lit> &lits = cnf->clauses[i]->literals;
+    if (lits.size() < 2 || lits.size() > static_cast<size_t>(max_size)) continue;
+
+    std::vector<var> vars;
+    for (auto L = lits.begin(); L != lits.end(); L++) vars.push_back(lit_var(*L));
+    std::sort(vars.begin(), vars.end());
+    if (std::adjacent_find(vars.begin(), vars.end()) != vars.end()) continue;
+
+    groups[vars].push_back(i);
+  }
+
+  for (auto g = groups.begin(); g != groups.end(); g++) {
+    const std::vector<var> &vars = g->first;
+    size_t k = vars.size();
+    size_t needed = static_cast<size_t>(1) << (k - 1);
+    if (g->second.size() < needed) continue;
+
+    // each clause forbids exactly one assignment of the k variables:
+    // the one falsifying all its literals
+    std::vector<int> forbidding[2];
+    std::vector<bool> seen(static_cast<size_t>(1) << k, false);
+    for (auto c = g->second.begin(); c != g->second.end(); c++) {
+      unsigned forbidden = 0;
+      std::vector<lit> &lits = cnf->clauses[*c]->literals;
+      for (auto L = lits.begin(); L != lits.end(); L++) {
+        size_t pos = std::lower_bound(vars.begin(), vars.end(), lit_var(*L)) - vars.begin();
+        if (!lit_is_pos(*L)) forbidden |= 1u << pos;
+      }
+      if (seen[forbidden]) continue;
+      seen[forbidden] = true;
+      forbidding[__builtin_popcount(forbidden) & 1].push_back(*c);
+    }
+
+    for (int parity = 0; parity < 2; parity++) {
+      if (forbidding[parity].size() != needed) continue;
+      // every assignment of this parity is excluded
+      xor_constraint x;
+      x.vars = vars;
+      x.rhs = parity == 0;
+      xors.push_back(x);
+      for (auto c = forbidding[parity].begin(); c != forbidding[parity].end(); c++) {
+        used[*c] = true;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < cnf->clauses.size(); i++) {
+    if (!used[i]) rest->clauses.push_back(cnf->clauses[i]);
+  }
+}
+
+xor_engine::xor_engine(std::vector<xor_constraint> &xors, int num_vars) :
+  num_cols(0), var_col(num_vars, -1), inconsistent(false), next_stamp(1) {
+  for (auto x = xors.begin(); x != xors.end(); x++) {
+    for (auto v = x->vars.begin(); v != x->vars.end(); v++) {
+      if (var_col[*v] < 0) {
+        var_col[*v] = num_cols++;
+        col_var.push_back(*v);
+      }
+    }
+  }
+  num_words = (num_cols + 63) / 64;
+
+  int n = xors.size();
+  bits.assign(static_cast<size_t>(n) * num_words, 0);
+  rhs.assign(n, 0);
+  pivot.assign(n, -1);
+  substituted.assign(num_words, 0);
+  row_stamp.assign(n, 0);
+  is_touched.assign(n, true);
+
+  std::vector<int> rows;
+  for (int r = 0; r < n; r++) {
+    uint64_t *R = row(r);
+    for (auto v = xors[r].vars.begin(); v != xors[r].vars.end(); v++) {
+      int c = var_col[*v];
+      R[c >> 6] ^= static_cast<uint64_t>(1) << (c & 63);
+    }
+    rhs[r] = xors[r].rhs;
+    rows.push_back(r);
+  }
+  // every row is checked for a unit at the first propagation
+  touched = rows;
+
+  repivot(rows);
+}
+
+void xor_engine::change_row(int r) {
+  if (!is_touched[r]) {
+    is_touched[r] = true;
+    touched.push_back(r);
+  }
+  // nothing undoes level 0
+  if (levels.empty() || row_stamp[r] == levels.back().stamp) return;
+  row_stamp[r] = levels.back().stamp;
+
+  saved_row s;
+  s.row = r;
+  s.rhs = rhs[r];
+  s.pivot = pivot[r];
+  trail.push_back(s);
+  uint64_t *R = row(r);
+  trail_bits.insert(trail_bits.end(), R, R + num_words);
+}
+
+void xor_engine::repivot(std::vector<int> &rows) {
+  for (auto it = rows.begin(); it != rows.end(); it++) {
+    int r = *it;
+    uint64_t *R = row(r);
+
+    int p = -1;
+    for (int w = 0; w < num_words && p < 0; w++) {
+      if (R[w]) p = w * 64 + __builtin_ctzll(R[w]);
+    }
+    if (p < 0) {
+      // 0 = rhs
+      if (rhs[r]) inconsistent = true;
+      continue;
+    }
+
+    pivot[r] = p;
+    for (int o = 0; o < num_rows(); o++) {
+      if (o == r) continue;
+      uint64_t *O = row(o);
+      if (!test_bit(O, p)) continue;
+      change_row(o);
+      for (int w = 0; w < num_words; w++) O[w] ^= R[w];
+      rhs[o] ^= rhs[r];
+    }
+  }
+}
+
+void xor_engine::push_level() {
+  level l;
+  l.trail_size = trail.size();
+  l.folded_size = folded.size();
+  l.inconsistent = inconsistent;
+  l.stamp = next_stamp++;
+  levels.push_back(l);
+}
+
+void xor_engine::pop_level() {
+  const level &l = levels.back();
+
+  // newest first, so a row saved twice ends up as it was before the level
+  while (trail.size() > l.trail_size) {
+    const saved_row &s = trail.back();
+    std::copy(trail_bits.end() - num_words, trail_bits.end(), row(s.row));
+    rhs[s.row] = s.rhs;
+    pivot[s.row] = s.pivot;
+    if (!is_touched[s.row]) {
+      is_touched[s.row] = true;
+      touched.push_back(s.row);
+    }
+    trail_bits.resize(trail_bits.size() - num_words);
+    trail.pop_back();
+  }
+
+  // a column folded on this level whose variable is still assigned, from
+  // below this level, has to be folded in again
+  while (folded.size() > l.folded_size) {
+    int c = folded.back();
+    substituted[c >> 6] &= ~(static_cast<uint64_t>(1) << (c & 63));
+    pending.push_back(c);
+    folded.pop_back();
+  }
+
+  inconsistent = l.inconsistent;
+  levels.pop_back();
+}
+
+bool xor_engine::propagate(const Interp *I, std::vector<lit> &implied) {
+  if (inconsistent) return false;
+
+  std::vector<int> lost_pivot;
+  while (!pending.empty()) {
+    int c = pending.back();
+    pending.pop_back();
+    if (test_bit(substituted.data(), c)) continue;
+    vinterp val = I->value(col_var[c]);
+    // unassigned again by a backtrack
+    if (val == vundef) continue;
+
+    substituted[c >> 6] |= static_cast<uint64_t>(1) << (c & 63);
+    if (!levels.empty()) folded.push_back(c);
+    uint64_t mask = ~(static_cast<uint64_t>(1) << (c & 63));
+    for (int r = 0; r < num_rows(); r++) {
+      uint64_t *R = row(r);
+      if (!test_bit(R, c)) continue;
+      change_row(r);
+      R[c >> 6] &= mask;
+      if (val == vtrue) rhs[r] ^= 1;
+      if (pivot[r] == c) {
+        pivot[r] = -1;
+        lost_pivot.push_back(r);
+      }
+    }
+  }
+
+  repivot(lost_pivot);
+  if (inconsistent) return false;
+
+  // a row with a single unassigned variable fixes it
+  for (auto it = touched.begin(); it != touched.end(); it++) {
+    int r = *it;
+    is_touched[r] = false;
+    if (pivot[r] < 0) continue;
+    uint64_t *R = row(r);
+    int count = 0;
+    for (int w = 0; w < num_words && count < 2; w++) count += __builtin_popcountll(R[w]);
+    if (count == 1) implied.push_back(mk_lit(col_var[pivot[r]], rhs[r]));
+  }
+  touched.clear();
+
+  return true;
+}
+
+var xor_engine::pick_unassigned(const Interp *I) const {
+  for (int c = 0; c < num_cols; c++) {
+    if (I->value(col_var[c]) == vundef) return col_var[c];
+  }
+  return -1;
+}
@@ -0,0 +1,116 @@
+#ifndef XOR_H
+#define XOR_H
+
+#include <cstdint>
+#include <vector>
+
+#include "cnf.h"
+#include "interp.h"
+
+// x1 ^ x2 ^ ... ^ xk = rhs
+struct xor_constraint {
+  std::vector<var> vars;
+  bool rhs;
+};
+
+// Recovers XOR constraints from clause form: k distinct variables covered
+// by all 2^(k-1) clauses that forbid the assignments of one parity, as
+// produced by the Tseitin encoding of <-> (k = 3) and of ! (k = 2).
+// Clauses that are part of a recovered XOR go into xors, all others are
+// appended to rest.
+void extract_xors(CNF *cnf, int max_size, std::vector<xor_constraint> &xors, CNF *rest);
+
+// Native XOR propagation by Gauss-Jordan elimination on packed bit-rows.
+// The matrix is kept in reduced row echelon form over the unassigned
+// variables; assigning a variable folds its column into the right hand
+// sides, and only rows that lose their pivot are re-eliminated. The engine
+// observes the interpretation, so only the variables assigned since the
+// last propagation are folded in, and a decision level keeps an undo trail
+// of the rows it changed instead of a copy of the matrix.
+class xor_engine : public interp_observer {
+  int num_cols;
+  int num_words;
+  std::vector<var> col_var;   // column -> variable
+  std::vector<int> var_col;   // variable -> column, or -1
+
+  std::vector<uint64_t> bits;          // row-major, num_words per row
+  std::vector<uint8_t> rhs;
+  std::vector<int> pivot;              // row -> pivot column, -1 if none
+  std::vector<uint64_t> substituted;   // columns already folded in
+  bool inconsistent;
+
+  // columns assigned since the last propagation, not yet folded in
+  std::vector<int> pending;
+
+  // a row as it was before the first change on a level
+  struct saved_row {
+    int row;
+    uint8_t rhs;
+    int pivot;
+  };
+
+  struct level {
+    size_t trail_size;
+    size_t folded_size;
+    bool inconsistent;
+    uint64_t stamp;
+  };
+
+  std::vector<saved_row> trail;
+  std::vector<uint64_t> trail_bits;   // num_words per trail entry
+  std::vector<int> folded;            // columns folded in above level 0
+  std::vector<level> levels;          // one per decision level
+  std::vector<uint64_t> row_stamp;    // row -> stamp of the level that saved it
+  uint64_t next_stamp;
+
+  // rows changed since the last propagation, the only ones that can have
+  // become unit
+  std::vector<int> touched;
+  std::vector<bool> is_touched;
+
+  uint64_t *row(int r) {
+    return &bits[static_cast<size_t>(r) * num_words];
+  }
+  static bool test_bit(const uint64_t *words, int c) {
+    return (words[c >> 6] >> (c & 63)) & 1;
+  }
+
+  int num_rows() const {
+    return rhs.size();
+  }
+
+  // called before row r changes: saves it once per level and marks it
+  void change_row(int r);
+
+  // give rows without a pivot a new one and eliminate it from every other row
+  void repivot(std::vector<int> &rows);
+
+public:
+  xor_engine(std::vector<xor_constraint> &xors, int num_vars);
+
+  size_t size() const {
+    return rhs.size();
+  }
+
+  // open and undo a decision level
+  void push_level();
+  void pop_level();
+
+  // fold the variables assigned since the last call into the matrix;
+  // returns false on a conflict, otherwise appends every implied literal
+  // to implied
+  bool propagate(const Interp *I, std::vector<lit> &implied);
+
+  void on_update(int var, vinterp, vinterp to) {
+    if (to != vundef && var_col[var] >= 0) pending.push_back(var_col[var]);
+  }
+
+  bool has_var(var v) const {
+    return var_col[v] >= 0;
+  }
+
+  // an unassigned variable that occurs in some XOR, or -1
+  var pick_unassigned(const Interp *I) const;
+};
+
+#endif /* XOR_H */